@@ -9,6 +9,9 @@
 #include <benchmark/benchmark.h>
 
 #include "neujson/document.h"
+#include "neujson/string_read_stream.h"
+#include "neujson/structural_reader.h"
+#include "neujson/tape_document.h"
 
 #include "benchmark.h"
 
@@ -25,7 +28,143 @@ static void BM_decode_value(benchmark::State &state,
   state.SetBytesProcessed(state.iterations() * torrent.size());
 }
 
+static void BM_decode_value_validate_utf8(benchmark::State &state,
+                                          const std::filesystem::path &path) {
+  auto ifs = std::ifstream(path, std::ifstream::binary);
+  const std::string torrent(std::istreambuf_iterator<char>{ifs},
+                            std::istreambuf_iterator<char>{});
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        neujson::Document()
+            .Parse<neujson::ParseFlags::kDefault |
+                   neujson::ParseFlags::kValidateUtf8>(torrent));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * torrent.size());
+}
+
+static void BM_decode_value_structural(benchmark::State &state,
+                                       const std::filesystem::path &path) {
+  auto ifs = std::ifstream(path, std::ifstream::binary);
+  const std::string torrent(std::istreambuf_iterator<char>{ifs},
+                            std::istreambuf_iterator<char>{});
+  // the structural index is allocated once and reused, as a server would
+  neujson::StructuralReader reader;
+
+  for (auto _ : state) {
+    neujson::StringReadStream read_stream(torrent);
+    neujson::Document document;
+    benchmark::DoNotOptimize(reader.Parse(read_stream, document));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * torrent.size());
+}
+
+static void BM_decode_value_arena(benchmark::State &state,
+                                  const std::filesystem::path &path) {
+  auto ifs = std::ifstream(path, std::ifstream::binary);
+  const std::string torrent(std::istreambuf_iterator<char>{ifs},
+                            std::istreambuf_iterator<char>{});
+
+  for (auto _ : state) {
+    // the whole tree goes with the arena, no per-value frees
+    benchmark::DoNotOptimize(neujson::Document(nullptr, 0).Parse(torrent));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * torrent.size());
+}
+
+static void BM_decode_value_reuse(benchmark::State &state,
+                                  const std::filesystem::path &path) {
+  auto ifs = std::ifstream(path, std::ifstream::binary);
+  const std::string torrent(std::istreambuf_iterator<char>{ifs},
+                            std::istreambuf_iterator<char>{});
+  neujson::Document doc(nullptr, 0);
+
+  for (auto _ : state) {
+    // the arena keeps its chunks, after the first parse nothing is allocated
+    doc.Clear();
+    benchmark::DoNotOptimize(doc.Parse(torrent));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * torrent.size());
+}
+
+static void BM_decode_tape(benchmark::State &state,
+                           const std::filesystem::path &path) {
+  auto ifs = std::ifstream(path, std::ifstream::binary);
+  const std::string torrent(std::istreambuf_iterator<char>{ifs},
+                            std::istreambuf_iterator<char>{});
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(neujson::TapeDocument().Parse(torrent));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * torrent.size());
+}
+
+static void BM_decode_value_insitu(benchmark::State &state,
+                                   const std::filesystem::path &path) {
+  auto ifs = std::ifstream(path, std::ifstream::binary);
+  const std::string torrent(std::istreambuf_iterator<char>{ifs},
+                            std::istreambuf_iterator<char>{});
+  std::string buffer;
+
+  for (auto _ : state) {
+    // the in-situ parse garbles its input, restore it untimed
+    state.PauseTiming();
+    buffer = torrent;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(
+        neujson::Document().ParseInsitu(buffer.data(), buffer.size()));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * torrent.size());
+}
+
+// records of more keys than objects index, none of them looked up: parsing
+// alone must not pay for the index
+static void BM_decode_value_wide_objects(benchmark::State &state) {
+  std::string json = "[";
+  for (int record = 0; record < 20000; ++record) {
+    json += record == 0 ? "{" : ",{";
+    for (int key = 0; key < 24; ++key) {
+      json += (key == 0 ? "\"field_" : ",\"field_") + std::to_string(key) +
+              "\":" + std::to_string(record * 24 + key);
+    }
+    json += "}";
+  }
+  json += "]";
+  neujson::Document doc(nullptr, 0);
+
+  for (auto _ : state) {
+    doc.Clear();
+    benchmark::DoNotOptimize(doc.Parse(json));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+
 BENCHMARK_CAPTURE(BM_decode_value, "canada", resource::canada);
 BENCHMARK_CAPTURE(BM_decode_value, "citm_catalog", resource::citm_catalog);
+BENCHMARK_CAPTURE(BM_decode_value_validate_utf8, "canada", resource::canada);
+BENCHMARK_CAPTURE(BM_decode_value_validate_utf8, "citm_catalog",
+                  resource::citm_catalog);
+BENCHMARK_CAPTURE(BM_decode_value_structural, "canada", resource::canada);
+BENCHMARK_CAPTURE(BM_decode_value_structural, "citm_catalog",
+                  resource::citm_catalog);
+BENCHMARK_CAPTURE(BM_decode_value_arena, "canada", resource::canada);
+BENCHMARK_CAPTURE(BM_decode_value_arena, "citm_catalog",
+                  resource::citm_catalog);
+BENCHMARK_CAPTURE(BM_decode_value_reuse, "canada", resource::canada);
+BENCHMARK_CAPTURE(BM_decode_value_reuse, "citm_catalog",
+                  resource::citm_catalog);
+BENCHMARK_CAPTURE(BM_decode_tape, "canada", resource::canada);
+BENCHMARK_CAPTURE(BM_decode_tape, "citm_catalog", resource::citm_catalog);
+BENCHMARK_CAPTURE(BM_decode_value_insitu, "canada", resource::canada);
+BENCHMARK_CAPTURE(BM_decode_value_insitu, "citm_catalog",
+                  resource::citm_catalog);
+BENCHMARK(BM_decode_value_wide_objects);
 
 BENCHMARK_MAIN();
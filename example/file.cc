@@ -22,11 +22,12 @@ int main() {
   neujson::fp is(input);
 
   neujson::Document doc;
-  const auto err = doc.ParseStream(is);
+  const auto result = doc.ParseStream(is);
   fclose(input);
 
-  if (err != neujson::error::OK) {
-    puts(neujson::ParseErrorStr(err));
+  if (result != neujson::error::OK) {
+    printf("%s at byte %zu\n", neujson::ParseErrorStr(result),
+           result.offset());
     return EXIT_FAILURE;
   }
 
@@ -0,0 +1,188 @@
+#ifndef NEUJSON_NEUJSON_ARENA_H_
+#define NEUJSON_NEUJSON_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <new>
+
+#include "neujson.h"
+#include "non_copyable.h"
+
+namespace neujson {
+
+/**
+ * @brief Monotonic allocator: hands out memory by bumping a pointer through
+ * chunks taken from the heap, optionally starting with a buffer the user
+ * supplies, and never frees anything on its own. Everything goes at once when
+ * the arena is destroyed, so a tree allocated in it is released in time
+ * proportional to the number of chunks rather than the number of values.
+ * Clear() makes all of it available again while keeping the chunks, so an
+ * arena reused for similar work stops allocating once it has grown enough.
+ *
+ * Allocate() is for whoever builds the tree. AllocateShared() is for what
+ * readers build lazily, e.g. the key index of a large object on its first
+ * lookup, and may be called from several threads at once.
+ */
+class Arena : NonCopyable {
+  // a chunk taken from the heap, its memory follows
+  struct Chunk {
+    Chunk *next;
+    std::size_t size;
+  };
+
+  static constexpr std::size_t kDefaultChunkSize = 64 * 1024;
+  static constexpr std::size_t kHeader =
+      (sizeof(Chunk) + alignof(std::max_align_t) - 1) &
+      ~(alignof(std::max_align_t) - 1);
+
+  // heap chunks in use, newest first
+  Chunk *chunks_ = nullptr;
+  // heap chunks kept by Clear()
+  Chunk *free_ = nullptr;
+  // heap chunks handed out by AllocateShared(), newest first
+  std::atomic<Chunk *> shared_ = nullptr;
+  char *current_ = nullptr;
+  char *end_ = nullptr;
+  char *buffer_ = nullptr;
+  char *buffer_end_ = nullptr;
+  std::size_t chunk_size_;
+
+public:
+  explicit Arena(const std::size_t chunk_size = kDefaultChunkSize)
+      : chunk_size_(chunk_size) {}
+
+  /**
+   * @brief Allocate from buffer first, which the arena does not free.
+   * @param buffer
+   * @param size
+   * @param chunk_size size of the heap chunks taken once buffer is used up
+   */
+  Arena(void *buffer, const std::size_t size,
+        const std::size_t chunk_size = kDefaultChunkSize)
+      : current_(static_cast<char *>(buffer)),
+        end_(static_cast<char *>(buffer) + size),
+        buffer_(static_cast<char *>(buffer)),
+        buffer_end_(static_cast<char *>(buffer) + size),
+        chunk_size_(chunk_size) {}
+
+  ~Arena() {
+    Free(chunks_);
+    Free(free_);
+    Free(shared_.load(std::memory_order_acquire));
+  }
+
+  /**
+   * @brief Make everything allocated so far available again, starting over
+   * with the buffer given to the constructor, if any. The heap chunks are
+   * kept for the allocations to come rather than freed, except those of
+   * AllocateShared().
+   */
+  void Clear() {
+    Free(shared_.exchange(nullptr, std::memory_order_acquire));
+    while (chunks_ != nullptr) {
+      Chunk *next = chunks_->next;
+      chunks_->next = free_;
+      free_ = chunks_;
+      chunks_ = next;
+    }
+    current_ = buffer_;
+    end_ = buffer_end_;
+  }
+
+  /**
+   * @brief Allocate size bytes aligned to align, a power of two no larger
+   * than alignof(std::max_align_t).
+   * @param size
+   * @param align
+   * @return
+   */
+  void *Allocate(const std::size_t size,
+                 const std::size_t align = alignof(std::max_align_t)) {
+    NEUJSON_ASSERT(align != 0 && (align & (align - 1)) == 0 &&
+                   align <= alignof(std::max_align_t));
+    const auto address = reinterpret_cast<uintptr_t>(current_);
+    const std::size_t padding = (0 - address) & (align - 1);
+    if (static_cast<std::size_t>(end_ - current_) < padding + size)
+        [[unlikely]] {
+      return AllocateSlow(size);
+    }
+    void *memory = current_ + padding;
+    current_ += padding + size;
+    return memory;
+  }
+
+  /**
+   * @brief Allocate size bytes aligned to alignof(std::max_align_t), safely
+   * from several threads at once. Each call takes a chunk of its own from the
+   * heap, released by Clear() or the destructor.
+   * @param size
+   * @return
+   */
+  void *AllocateShared(const std::size_t size) {
+    auto *chunk = static_cast<Chunk *>(::operator new(kHeader + size));
+    chunk->size = size;
+    chunk->next = shared_.load(std::memory_order_relaxed);
+    while (!shared_.compare_exchange_weak(chunk->next, chunk,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed)) {
+    }
+    return reinterpret_cast<char *>(chunk) + kHeader;
+  }
+
+private:
+  static void Free(Chunk *chunk) {
+    while (chunk != nullptr) {
+      Chunk *next = chunk->next;
+      ::operator delete(chunk);
+      chunk = next;
+    }
+  }
+
+  // the smallest kept chunk of at least size bytes, else a new one of size
+  Chunk *TakeChunk(const std::size_t size) {
+    Chunk **best = nullptr;
+    for (Chunk **link = &free_; *link != nullptr; link = &(*link)->next) {
+      if ((*link)->size >= size &&
+          (best == nullptr || (*link)->size < (*best)->size)) {
+        best = link;
+      }
+    }
+    if (best != nullptr) {
+      Chunk *chunk = *best;
+      *best = chunk->next;
+      return chunk;
+    }
+    auto *chunk = static_cast<Chunk *>(::operator new(kHeader + size));
+    chunk->size = size;
+    return chunk;
+  }
+
+  // chunks are aligned to max_align_t, so their first byte needs no padding
+  void *AllocateSlow(const std::size_t size) {
+    if (size > chunk_size_ / 2) {
+      // a dedicated chunk, the current one keeps serving small requests
+      Chunk *chunk = TakeChunk(size);
+      if (chunks_ == nullptr) {
+        chunk->next = nullptr;
+        chunks_ = chunk;
+      } else {
+        chunk->next = chunks_->next;
+        chunks_->next = chunk;
+      }
+      return reinterpret_cast<char *>(chunk) + kHeader;
+    }
+    Chunk *chunk = TakeChunk(chunk_size_);
+    chunk->next = chunks_;
+    chunks_ = chunk;
+    current_ = reinterpret_cast<char *>(chunk) + kHeader + size;
+    end_ = reinterpret_cast<char *>(chunk) + kHeader + chunk->size;
+    return reinterpret_cast<char *>(chunk) + kHeader;
+  }
+};
+
+} // namespace neujson
+
+#endif // NEUJSON_NEUJSON_ARENA_H_
@@ -5,13 +5,20 @@
 #ifndef NEUJSON_NEUJSON_DOCUMENT_H_
 #define NEUJSON_NEUJSON_DOCUMENT_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
 #include <string_view>
-#include <variant>
 #include <vector>
 
+#include "arena.h"
 #include "exception.h"
+#include "insitu_string_stream.h"
 #include "internal/ieee754.h"
 #include "neujson.h"
 #include "reader.h"
@@ -26,26 +33,92 @@ NEUJSON_DIAG_OFF(effc++)
 namespace neujson {
 
 class Document : public Value {
+  // an array or object being parsed, its values are on values_ from start
   struct Level {
-    Value *value;
-    int value_count;
+    Type type;
+    std::size_t start;
 
-    explicit Level(Value *value) : value(value), value_count(0) {}
-
-    [[nodiscard]] Type type() const { return value->GetType(); }
-    [[nodiscard]] Value *lastValue() const;
+    Level(const Type type, const std::size_t start)
+        : type(type), start(start) {}
   };
 
   std::vector<Level> stack_;
-  Value key_;
+  // the values of the open containers, keys and values alternating for
+  // objects, until each container is allocated at its end with its size
+  std::vector<Value> values_;
+  // with ParseFlags::kInternKeys, the keys of the parse too long to be
+  // stored inline, by open addressing on their hash in a power-of-two
+  // number of slots
+  struct InternedKey {
+    std::size_t hash = 0;
+    Value key;
+  };
+  std::vector<InternedKey> interned_;
+  std::size_t interned_count_ = 0;
+  // the Reader's scratch space for strings with escapes, kept across parses
+  std::string scratch_;
   bool see_value_ = false;
+  bool insitu_ = false;
+  bool intern_keys_ = false;
+  // the arena the document owns, shared by its copies
+  std::shared_ptr<Arena> own_arena_;
+  // where the tree is allocated, the heap if null
+  Arena *arena_ = nullptr;
 
 public:
-  error::ParseError Parse(const char *json, size_t len);
-  error::ParseError Parse(std::string_view json);
-
-  template <required::read_stream::HasAllRequiredFunctions ReadStream>
-  error::ParseError ParseStream(ReadStream &rs);
+  Document() = default;
+
+  /**
+   * @brief Allocate the tree in arena, which must outlive the document and
+   * every Value taken from it.
+   * @param arena
+   */
+  explicit Document(Arena &arena) : arena_(&arena) {}
+
+  /**
+   * @brief Allocate the tree in an arena of the document's own, starting with
+   * buffer if given, and release all of it at once with the document.
+   * @param buffer may be null
+   * @param size
+   */
+  Document(void *buffer, const std::size_t size)
+      : own_arena_(std::make_shared<Arena>(buffer, size)),
+        arena_(own_arena_.get()) {}
+
+  template <unsigned Flags = ParseFlags::kDefault>
+  [[nodiscard]] ParseResult Parse(const char *json, size_t len);
+  template <unsigned Flags = ParseFlags::kDefault>
+  [[nodiscard]] ParseResult Parse(std::string_view json);
+
+  /**
+   * @brief Parse json destructively: strings are unescaped in place and the
+   * document's strings refer to them, so json must outlive the document.
+   * @param json
+   * @param len
+   * @return
+   */
+  template <unsigned Flags = ParseFlags::kDefault>
+  [[nodiscard]] ParseResult ParseInsitu(char *json, size_t len);
+  template <unsigned Flags = ParseFlags::kDefault>
+  [[nodiscard]] ParseResult ParseInsitu(char *json);
+
+  /**
+   * @brief Parse into the document, replacing the tree of an earlier parse.
+   * The parse stacks keep their capacity from one parse to the next.
+   * @param rs
+   * @return
+   */
+  template <unsigned Flags = ParseFlags::kDefault,
+            required::read_stream::HasAllRequiredFunctions ReadStream>
+  [[nodiscard]] ParseResult ParseStream(ReadStream &rs);
+
+  /**
+   * @brief Drop the tree and, if the document owns its arena, make the
+   * arena's memory available to the next parse, which then allocates
+   * nothing once the arena has grown to fit. Values taken from an arena
+   * document must not be used afterwards, as if it had been destroyed.
+   */
+  void Clear();
 
   // handler
   bool Null();
@@ -61,29 +134,65 @@ public:
   bool EndArray();
 
 private:
-  Value *AddValue(Value &&value);
+  void DropTree();
+  void AddValue(Value &&value);
+  [[nodiscard]] Value InternKey(std::string_view str);
+  [[nodiscard]] Value MakeString(std::string_view str) const;
+  [[nodiscard]] Value MakeContainer(Type type, Value *values,
+                                    std::size_t count) const;
+  void EndContainer(Type type);
 };
 
-inline Value *Document::Level::lastValue() const {
-  if (type() == NEU_ARRAY) {
-    return &std::get<NEU_ARRAY_TYPE>(value->data_)->back();
-  } else {
-    return &std::get<NEU_OBJECT_TYPE>(value->data_)->back().value_;
-  }
+template <unsigned Flags>
+ParseResult Document::Parse(const char *json, const size_t len) {
+  return Parse<Flags>(std::string_view(json, len));
 }
 
-inline error::ParseError Document::Parse(const char *json, const size_t len) {
-  return Parse(std::string_view(json, len));
+template <unsigned Flags>
+ParseResult Document::Parse(const std::string_view json) {
+  StringReadStream string_read_stream(json);
+  return ParseStream<Flags>(string_read_stream);
 }
 
-inline error::ParseError Document::Parse(const std::string_view json) {
-  StringReadStream string_read_stream(json);
-  return ParseStream(string_read_stream);
+template <unsigned Flags>
+ParseResult Document::ParseInsitu(char *json, const size_t len) {
+  InsituStringStream insitu_string_stream(json, len);
+  insitu_ = true;
+  const auto result = ParseStream<Flags>(insitu_string_stream);
+  insitu_ = false;
+  return result;
+}
+
+template <unsigned Flags> ParseResult Document::ParseInsitu(char *json) {
+  return ParseInsitu<Flags>(json, std::strlen(json));
+}
+
+template <unsigned Flags,
+          required::read_stream::HasAllRequiredFunctions ReadStream>
+ParseResult Document::ParseStream(ReadStream &rs) {
+  DropTree();
+  intern_keys_ = (Flags & ParseFlags::kInternKeys) != 0;
+  const auto result = Reader::Parse<Flags>(rs, *this, scratch_);
+  if constexpr ((Flags & ParseFlags::kInternKeys) != 0) {
+    // the tree holds the keys now, the table keeps only its slots
+    std::ranges::fill(interned_, InternedKey());
+    interned_count_ = 0;
+  }
+  return result;
 }
 
-template <required::read_stream::HasAllRequiredFunctions ReadStream>
-error::ParseError Document::ParseStream(ReadStream &rs) {
-  return Reader::Parse(rs, *this);
+inline void Document::Clear() {
+  DropTree();
+  if (own_arena_ == nullptr) {
+    return;
+  }
+  if (own_arena_.use_count() == 1) {
+    own_arena_->Clear();
+  } else {
+    // a copy of the document still uses the arena, it keeps it
+    own_arena_ = std::make_shared<Arena>();
+    arena_ = own_arena_.get();
+  }
 }
 
 inline bool Document::Null() {
@@ -112,103 +221,139 @@ inline bool Document::Double(const internal::Double d) {
 }
 
 inline bool Document::String(const std::string_view str) {
-  AddValue(Value(str));
+  AddValue(MakeString(str));
   return true;
 }
 
 inline bool Document::Key(const std::string_view str) {
-  AddValue(Value(str));
+  // short keys are stored inline and in-situ keys borrowed, sharing would
+  // save nothing
+  if (intern_keys_ && !insitu_ && str.size() > kShortLength) {
+    AddValue(InternKey(str));
+  } else {
+    AddValue(MakeString(str));
+  }
   return true;
 }
 
 inline bool Document::StartObject() {
-  auto value = AddValue(Value(NEU_OBJECT));
-  stack_.emplace_back(value);
+  stack_.emplace_back(NEU_OBJECT, values_.size());
   return true;
 }
 
 inline bool Document::EndObject() {
-  NEUJSON_ASSERT(!stack_.empty());
-  NEUJSON_ASSERT(stack_.back().type() == NEU_OBJECT);
-  stack_.pop_back();
+  EndContainer(NEU_OBJECT);
   return true;
 }
 
 inline bool Document::StartArray() {
-  auto value = AddValue(Value(NEU_ARRAY));
-  stack_.emplace_back(value);
+  stack_.emplace_back(NEU_ARRAY, values_.size());
   return true;
 }
 
 inline bool Document::EndArray() {
-  NEUJSON_ASSERT(!stack_.empty());
-  NEUJSON_ASSERT(stack_.back().type() == NEU_ARRAY);
-  stack_.pop_back();
+  EndContainer(NEU_ARRAY);
   return true;
 }
 
-inline Value *Document::AddValue(Value &&value) {
-  Type type = value.GetType();
-  (void)type;
-  if (see_value_) {
-    NEUJSON_ASSERT(!stack_.empty() && "root not singular");
-  } else {
-    NEUJSON_ASSERT(type_ == NEU_NULL);
-    see_value_ = true;
-    type_ = value.type_;
-
-    switch (type) {
-    case NEU_NULL:
-      break;
-    case NEU_BOOL:
-      data_ = std::get<NEU_BOOL_TYPE>(value.data_);
-      break;
-    case NEU_INT32:
-      data_ = std::get<NEU_INT32_TYPE>(value.data_);
-      break;
-    case NEU_INT64:
-      data_ = std::get<NEU_INT64_TYPE>(value.data_);
-      break;
-    case NEU_DOUBLE:
-      data_ = std::get<NEU_DOUBLE_TYPE>(value.data_);
-      break;
-    case NEU_STRING:
-      data_ = std::get<NEU_STRING_TYPE>(value.data_);
-      std::get<NEU_STRING_TYPE>(value.data_) = nullptr;
-      break;
-    case NEU_ARRAY:
-      data_ = std::get<NEU_ARRAY_TYPE>(value.data_);
-      std::get<NEU_ARRAY_TYPE>(value.data_) = nullptr;
-      break;
-    case NEU_OBJECT:
-      data_ = std::get<NEU_OBJECT_TYPE>(value.data_);
-      std::get<NEU_OBJECT_TYPE>(value.data_) = nullptr;
-      break;
-    default:
-      break;
+inline void Document::DropTree() {
+  stack_.clear();
+  values_.clear();
+  see_value_ = false;
+  Value::operator=(Value());
+}
+
+inline Value Document::MakeString(const std::string_view str) const {
+  if (insitu_) {
+    return Value(StringRef(str));
+  }
+  return arena_ != nullptr ? Value(str, *arena_) : Value(str);
+}
+
+inline Value Document::InternKey(const std::string_view str) {
+  // at most half full
+  if ((interned_count_ + 1) * 2 > interned_.size()) {
+    std::vector<InternedKey> slots(interned_.empty() ? 64
+                                                     : interned_.size() * 2);
+    const std::size_t mask = slots.size() - 1;
+    for (auto &slot : interned_) {
+      if (slot.key.IsNull()) {
+        continue;
+      }
+      std::size_t i = slot.hash & mask;
+      while (!slots[i].key.IsNull()) {
+        i = (i + 1) & mask;
+      }
+      slots[i] = std::move(slot);
     }
-    value.type_ = NEU_NULL;
-    return this;
+    interned_ = std::move(slots);
   }
 
-  auto &top = stack_.back();
-  if (top.type() == NEU_ARRAY) {
-    top.value->AddValue(std::move(value));
-    top.value_count++;
-    return top.lastValue();
+  const std::size_t hash = std::hash<std::string_view>{}(str);
+  const std::size_t mask = interned_.size() - 1;
+  std::size_t i = hash & mask;
+  for (; !interned_[i].key.IsNull(); i = (i + 1) & mask) {
+    if (interned_[i].hash == hash && interned_[i].key.GetStringView() == str) {
+      return interned_[i].key;
+    }
+  }
+  interned_[i].hash = hash;
+  interned_[i].key = MakeString(str);
+  interned_count_++;
+  return interned_[i].key;
+}
+
+inline Value Document::MakeContainer(const Type type, Value *values,
+                                     const std::size_t count) const {
+  if (count == 0) {
+    return arena_ != nullptr ? Value(type, *arena_) : Value(type);
+  }
+  Value container(type);
+  if (type == NEU_ARRAY) {
+    auto *array = Array::Create(count, arena_);
+    for (std::size_t i = 0; i < count; ++i) {
+      array->emplace_back(std::move(values[i]));
+    }
+    container.array_ = array;
   } else {
-    NEUJSON_ASSERT(top.type() == NEU_OBJECT);
-    if (top.value_count % 2 == 0) {
-      NEUJSON_ASSERT(type == NEU_STRING && "miss quotation mark");
-      key_ = std::move(value);
-      top.value_count++;
-      return &key_;
-    } else {
-      top.value->AddMember(std::move(key_), std::move(value));
-      top.value_count++;
-      return top.lastValue();
+    NEUJSON_ASSERT(count % 2 == 0);
+    auto *object = Object::Create(count / 2, arena_);
+    for (std::size_t i = 0; i < count; i += 2) {
+      NEUJSON_ASSERT(object->find(values[i].GetStringView()) ==
+                     object->end());
+      object->emplace_back(std::move(values[i]), std::move(values[i + 1]));
     }
+    container.object_ = object;
+  }
+  if (arena_ == nullptr) {
+    container.flags_ |= kRefCounted;
+  }
+  return container;
+}
+
+inline void Document::EndContainer(const Type type) {
+  NEUJSON_ASSERT(!stack_.empty());
+  NEUJSON_ASSERT(stack_.back().type == type);
+  const std::size_t start = stack_.back().start;
+  stack_.pop_back();
+  Value container =
+      MakeContainer(type, values_.data() + start, values_.size() - start);
+  values_.resize(start);
+  AddValue(std::move(container));
+}
+
+inline void Document::AddValue(Value &&value) {
+  if (stack_.empty()) {
+    NEUJSON_ASSERT(!see_value_ && "root not singular");
+    NEUJSON_ASSERT(GetType() == NEU_NULL);
+    see_value_ = true;
+    Value::operator=(std::move(value));
+    return;
   }
+  NEUJSON_ASSERT(stack_.back().type == NEU_ARRAY ||
+                 (values_.size() - stack_.back().start) % 2 == 1 ||
+                 (value.GetType() == NEU_STRING && "miss quotation mark"));
+  values_.emplace_back(std::move(value));
 }
 
 } // namespace neujson
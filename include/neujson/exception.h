@@ -5,7 +5,11 @@
 #ifndef NEUJSON_NEUJSON_EXCEPTION_H_
 #define NEUJSON_NEUJSON_EXCEPTION_H_
 
+#include <cstddef>
+
+#include <algorithm>
 #include <exception>
+#include <string_view>
 
 #include "neujson.h"
 
@@ -27,6 +31,9 @@ namespace neujson {
   ERR(MISS_COLON, "miss colon")                                                \
   ERR(MISS_COMMA_OR_CURLY_BRACKET, "miss comma or curly bracket")              \
   ERR(USER_STOPPED, "user stopped parse")                                      \
+  ERR(DEPTH_EXCEEDED, "nesting too deep")                                      \
+  ERR(BAD_STRING_UTF8, "bad utf-8 string")                                     \
+  ERR(NEED_MORE_INPUT, "need more input")                                      \
   //
 
 namespace error {
@@ -63,6 +70,52 @@ public:
   [[nodiscard]] error::ParseError err() const { return err_; }
 };
 
+/**
+ * @brief 1-based line and column of a byte, the column counted in bytes.
+ */
+struct TextPosition {
+  std::size_t line;
+  std::size_t column;
+};
+
+/**
+ * @brief Outcome of a parse: the error code and the offset of the byte the
+ * reader stopped at, counted from where it started. On failure that is the
+ * offending byte, or the end of the input if it ended too early; on success
+ * it is the end of what was parsed. The offset costs the parse nothing, the
+ * line and column are only counted when asked for.
+ *
+ * It converts to the error code, so it compares and switches like one.
+ */
+class ParseResult {
+  error::ParseError err_ = error::OK;
+  std::size_t offset_ = 0;
+
+public:
+  ParseResult() = default;
+  ParseResult(const error::ParseError err, const std::size_t offset)
+      : err_(err), offset_(offset) {}
+
+  operator error::ParseError() const { return err_; }
+
+  [[nodiscard]] error::ParseError err() const { return err_; }
+  [[nodiscard]] std::size_t offset() const { return offset_; }
+
+  /**
+   * @brief Line and column of the offset.
+   * @param input the parsed input, from where the parse started
+   * @return
+   */
+  [[nodiscard]] TextPosition position(const std::string_view input) const {
+    const std::string_view before = input.substr(0, offset_);
+    const auto lines = static_cast<std::size_t>(
+        std::count(before.begin(), before.end(), '\n'));
+    // npos + 1 wraps around to 0 on the first line
+    const std::size_t line_start = before.rfind('\n') + 1;
+    return {lines + 1, before.size() - line_start + 1};
+  }
+};
+
 } // namespace neujson
 
 #endif // NEUJSON_NEUJSON_EXCEPTION_H_
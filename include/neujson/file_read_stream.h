@@ -86,6 +86,11 @@ public:
     read();
   }
 
+  // bytes taken from the file so far
+  [[nodiscard]] std::size_t tell() const {
+    return read_total_ + static_cast<std::size_t>(current_ - buffer_);
+  }
+
 private:
   void read() {
     if (current_ < buffer_last_) {
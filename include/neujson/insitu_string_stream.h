@@ -0,0 +1,69 @@
+#ifndef NEUJSON_NEUJSON_INSITU_STRING_STREAM_H_
+#define NEUJSON_NEUJSON_INSITU_STRING_STREAM_H_
+
+#include <string_view>
+
+#include "neujson.h"
+#include "non_copyable.h"
+
+namespace neujson {
+
+/**
+ * @brief Read stream over a mutable buffer. The Reader unescapes strings back
+ * into the buffer itself, so every string it hands out points into the input,
+ * which is left garbled after the parse.
+ */
+class InsituStringStream : public NonCopyable {
+  char *current_;
+  char *end_;
+
+public:
+  InsituStringStream(char *json, const std::size_t length)
+      : current_(json), end_(json + length) {}
+
+  [[nodiscard]] bool hasNext() const { return current_ != end_; }
+
+  [[nodiscard]] char peek() const { return hasNext() ? *current_ : '\0'; }
+
+  char next() {
+    if (hasNext()) {
+      return *current_++;
+    }
+    return '\0';
+  }
+
+  std::string_view next(const std::size_t n) {
+    const char *start = current_;
+    if (static_cast<std::size_t>(end_ - current_) >= n) {
+      current_ += n;
+    }
+    return {start, static_cast<std::size_t>(current_ - start)};
+  }
+
+  void skip(const std::size_t n) {
+    if (static_cast<std::size_t>(end_ - current_) >= n) {
+      current_ += n;
+    }
+  }
+
+  void assertNext(const char ch) {
+    (void)ch;
+    NEUJSON_ASSERT(peek() == ch);
+    next();
+  }
+
+  // contiguous input, see required::read_stream::IsContiguous
+  [[nodiscard]] const char *getAddr() const { return current_; }
+  [[nodiscard]] const char *getEnd() const { return end_; }
+  void setAddr(const char *addr) {
+    NEUJSON_ASSERT(addr >= current_ && addr <= end_);
+    current_ += addr - current_;
+  }
+
+  // writable input, see required::read_stream::IsInsitu
+  [[nodiscard]] char *getMutableAddr() const { return current_; }
+};
+
+} // namespace neujson
+
+#endif // NEUJSON_NEUJSON_INSITU_STRING_STREAM_H_
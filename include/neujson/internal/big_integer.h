@@ -5,6 +5,8 @@
 #ifndef NEUJSON_INCLUDE_NEUJSON_INTERNAL_BIG_INTEGER_H_
 #define NEUJSON_INCLUDE_NEUJSON_INTERNAL_BIG_INTEGER_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 
 #include "neujson/neujson.h"
@@ -71,14 +73,14 @@ public:
     return *this;
   }
 
-  bool operator==(const BigInteger *big_integer) const {
-    return count_ == big_integer->count_ &&
-           std::memcmp(digits_, big_integer->digits_, count_ * sizeof(Type)) ==
+  bool operator==(const BigInteger &big_integer) const {
+    return count_ == big_integer.count_ &&
+           std::memcmp(digits_, big_integer.digits_, count_ * sizeof(Type)) ==
                0;
   }
 
   bool operator==(const Type &type) const {
-    return count_ == 1 & digits_[0] == type;
+    return count_ == 1 && digits_[0] == type;
   }
 
   BigInteger &operator<<=(std::size_t shift) {
@@ -87,7 +89,7 @@ public:
     }
 
     std::size_t offset = shift / kTypeBit;
-    std::size_t inner_shift = shift & kTypeBit;
+    std::size_t inner_shift = shift % kTypeBit;
     NEUJSON_ASSERT(count_ + offset <= kCapacity);
 
     if (inner_shift == 0) {
@@ -215,7 +217,46 @@ public:
     return *this;
   }
 
-  [[nodiscard]] bool IsZero() const { return count_ == 1 & digits_[0] == 1; }
+  /**
+   * @brief |*this - big_integer| into out.
+   * @param big_integer
+   * @param out
+   * @return whether *this < big_integer
+   */
+  bool Difference(const BigInteger &big_integer, BigInteger *out) const {
+    const int cmp = Compare(big_integer);
+    const BigInteger *a = cmp < 0 ? &big_integer : this; // a >= b
+    const BigInteger *b = cmp < 0 ? this : &big_integer;
+
+    *out = 0;
+    Type borrow = 0;
+    for (std::size_t i = 0; i < a->count_; ++i) {
+      const Type ai = a->digits_[i];
+      const Type bi = i < b->count_ ? b->digits_[i] : 0;
+      const Type d = ai - bi - borrow;
+      borrow = (ai < bi || ai - bi < borrow) ? 1 : 0;
+      out->digits_[i] = d;
+      if (d != 0) {
+        out->count_ = i + 1;
+      }
+    }
+
+    return cmp < 0;
+  }
+
+  [[nodiscard]] int Compare(const BigInteger &big_integer) const {
+    if (count_ != big_integer.count_) {
+      return count_ < big_integer.count_ ? -1 : 1;
+    }
+    for (std::size_t i = count_; i-- > 0;) {
+      if (digits_[i] != big_integer.digits_[i]) {
+        return digits_[i] < big_integer.digits_[i] ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  [[nodiscard]] bool IsZero() const { return count_ == 1 && digits_[0] == 0; }
 
 private:
   void PushBack(Type digit) {
@@ -247,17 +288,17 @@ private:
   static uint64_t MulAdd64(uint64_t a, uint64_t b, uint64_t k,
                            uint64_t *out_high) {
 #if defined(_MSC_VER) && defined(_M_AMD64)
-    uint64_t low = _umul128(_a, _b, &_out_high) + _k;
-    if (low < _k) {
-      *(_out_high)++;
+    uint64_t low = _umul128(a, b, out_high) + k;
+    if (low < k) {
+      ++*out_high;
     } // with carry
     return low;
 #elif (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 6)) &&              \
     defined(__x86_64__)
     __extension__ typedef unsigned __int128 uint128_t;
-    uint128_t p = static_cast<uint128_t>(_a) * static_cast<uint128_t>(_b);
-    p += _k;
-    *_out_high = static_cast<uint64_t>(p >> 64);
+    uint128_t p = static_cast<uint128_t>(a) * static_cast<uint128_t>(b);
+    p += k;
+    *out_high = static_cast<uint64_t>(p >> 64);
     return static_cast<uint64_t>(p);
 #else
     const uint64_t al = a & 0xFFFFFFFF, ah = a >> 32, bl = b & 0xFFFFFFFF,
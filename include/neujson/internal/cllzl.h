@@ -13,8 +13,10 @@
 #include <intrin.h>
 #if defined(_WIN64)
 #pragma intrinsic(_BitScanReverse64)
+#pragma intrinsic(_BitScanForward64)
 #else
 #pragma intrinsic(_BitScanReverse)
+#pragma intrinsic(_BitScanForward)
 #endif
 #endif
 
@@ -54,6 +56,41 @@ inline uint32_t clzll(uint64_t n) {
 #endif // _MSC_VER
 }
 
+inline uint32_t ctzll(uint64_t n) {
+  NEUJSON_ASSERT(n != 0);
+
+#if defined(_MSC_VER) && !defined(UNDER_CE)
+  unsigned long r = 0;
+#if defined(_WIN64)
+  _BitScanForward64(&r, n);
+#else
+  // scan the low 32 bits.
+  if (_BitScanForward(&r, static_cast<uint32_t>(n & 0xFFFFFFFF))) {
+    return r;
+  }
+
+  // scan the high 32 bits.
+  _BitScanForward(&r, static_cast<uint32_t>(n >> 32));
+  r += 32;
+#endif // _WIN64
+
+  return r;
+#elif (defined(__GNUC__) && __GNUC__ >= 4) ||                                  \
+    NEUJSON_HAS_BUILTIN(__builtin_ctzll)
+  // __builtin_ctzll wrapper
+  return static_cast<uint32_t>(__builtin_ctzll(n));
+#else
+  // naive version
+  uint32_t r = 0;
+  while (!(n & 1)) {
+    n >>= 1;
+    ++r;
+  }
+
+  return r;
+#endif // _MSC_VER
+}
+
 } // namespace neujson::internal
 
 #endif // NEUJSON_NEUJSON_INTERNAL_CLLZL_H_
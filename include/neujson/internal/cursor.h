@@ -0,0 +1,102 @@
+#ifndef NEUJSON_INCLUDE_NEUJSON_INTERNAL_CURSOR_H_
+#define NEUJSON_INCLUDE_NEUJSON_INTERNAL_CURSOR_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include <string_view>
+
+#include "neujson/neujson.h"
+
+namespace neujson::internal {
+
+/**
+ * @brief Raw pointer view over a contiguous input, used by the Reader in place
+ * of any read stream that exposes its buffer. Being a local object, the two
+ * pointers stay in registers across the whole parse.
+ */
+class Cursor {
+  const char *current_;
+  const char *end_;
+
+public:
+  Cursor(const char *begin, const char *end) : current_(begin), end_(end) {}
+
+  [[nodiscard]] bool hasNext() const { return current_ != end_; }
+
+  // '\0' is the end-of-buffer sentinel, it never matches a JSON token
+  [[nodiscard]] char peek() const { return hasNext() ? *current_ : '\0'; }
+
+  char next() { return hasNext() ? *current_++ : '\0'; }
+
+  void skip(const std::size_t n) {
+    current_ += n <= static_cast<std::size_t>(end_ - current_)
+                    ? n
+                    : static_cast<std::size_t>(end_ - current_);
+  }
+
+  void assertNext(const char ch) {
+    (void)ch;
+    NEUJSON_ASSERT(peek() == ch);
+    ++current_;
+  }
+
+  [[nodiscard]] const char *getAddr() const { return current_; }
+  [[nodiscard]] const char *getEnd() const { return end_; }
+  void setAddr(const char *addr) { current_ = addr; }
+};
+
+/**
+ * @brief Cursor over an input followed by at least kPadding readable bytes.
+ */
+class PaddedCursor : public Cursor {
+public:
+  static constexpr std::size_t kPadding = 64;
+
+  using Cursor::Cursor;
+};
+
+/**
+ * @brief Cursor over a writable input, see InsituStringStream.
+ */
+class InsituCursor : public Cursor {
+public:
+  InsituCursor(char *begin, const char *end) : Cursor(begin, end) {}
+
+  // the cursor was built from a mutable buffer, so is every position in it
+  [[nodiscard]] char *getMutableAddr() const {
+    return const_cast<char *>(getAddr());
+  }
+};
+
+/**
+ * @brief Unescaped string output written over the string's own source. Every
+ * escape sequence is at least as long as the characters it stands for, so the
+ * output never overtakes the read position.
+ */
+class InsituBuffer {
+  char *begin_;
+  char *end_;
+
+public:
+  explicit InsituBuffer(char *begin) : begin_(begin), end_(begin) {}
+
+  [[nodiscard]] bool empty() const { return begin_ == end_; }
+
+  void push_back(const char ch) { *end_++ = ch; }
+
+  void append(const char *first, const char *last) {
+    if (first != end_) {
+      std::memmove(end_, first, static_cast<std::size_t>(last - first));
+    }
+    end_ += last - first;
+  }
+
+  operator std::string_view() const {
+    return {begin_, static_cast<std::size_t>(end_ - begin_)};
+  }
+};
+
+} // namespace neujson::internal
+
+#endif // NEUJSON_INCLUDE_NEUJSON_INTERNAL_CURSOR_H_
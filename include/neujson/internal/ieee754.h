@@ -26,6 +26,8 @@ class Double {
       NEUJSON_UINT64_C2(0x7FF00000, 0x00000000);
   static constexpr uint64_t kFractionMask =
       NEUJSON_UINT64_C2(0x000FFFFF, 0xFFFFFFFF);
+  static constexpr uint64_t kHiddenBit =
+      NEUJSON_UINT64_C2(0x00100000, 0x00000000);
 
 public:
   Double() = default;
@@ -57,6 +59,40 @@ public:
   [[nodiscard]] bool IsZero() const {
     return (u_ & (kExponentMask | kFractionMask)) == 0;
   }
+
+  // value == IntegerSignificand() * 2^IntegerExponent(), for finite values
+  [[nodiscard]] uint64_t IntegerSignificand() const {
+    return IsNormal() ? Fraction() | kHiddenBit : Fraction();
+  }
+  [[nodiscard]] int IntegerExponent() const {
+    return (IsNormal() ? Exponent() : kStartExponent) - kFractionSize;
+  }
+
+  // neighbours of a non-negative value, stepping across the exponents too
+  [[nodiscard]] double NextPositiveDouble() const {
+    NEUJSON_ASSERT(!Sign());
+    return Double(u_ + 1).Value();
+  }
+  [[nodiscard]] double PrevPositiveDouble() const {
+    NEUJSON_ASSERT(!Sign() && !IsZero());
+    return Double(u_ - 1).Value();
+  }
+
+  /**
+   * @brief Significand bits a double keeps for a value in [2^(order-1),
+   * 2^order), fewer than 53 in the subnormal range.
+   * @param order
+   * @return
+   */
+  static int EffectiveSignificandSize(const int order) {
+    if (order >= -1021) {
+      return 53;
+    }
+    if (order <= -1074) {
+      return 0;
+    }
+    return order + 1074;
+  }
 };
 
 } // namespace neujson::internal
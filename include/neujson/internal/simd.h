@@ -0,0 +1,977 @@
+#ifndef NEUJSON_INCLUDE_NEUJSON_INTERNAL_SIMD_H_
+#define NEUJSON_INCLUDE_NEUJSON_INTERNAL_SIMD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "cllzl.h"
+#include "neujson/neujson.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||            \
+    defined(_M_IX86)
+#define NEUJSON_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define NEUJSON_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// kernels above the compiled baseline are enabled per function, so one binary
+// carries every implementation and picks one at runtime
+#if defined(NEUJSON_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define NEUJSON_TARGET(_isa) __attribute__((target(_isa)))
+#else
+#define NEUJSON_TARGET(_isa)
+#endif
+
+namespace neujson {
+
+#define IMPLEMENTATION_TABLE(IMPL)                                             \
+  IMPL(SCALAR, "scalar")                                                       \
+  IMPL(SSE2, "sse2")                                                           \
+  IMPL(SSE42, "sse4.2")                                                        \
+  IMPL(AVX2, "avx2")                                                           \
+  IMPL(AVX512, "avx512bw")                                                     \
+  IMPL(NEON, "neon")                                                           \
+  //
+
+namespace simd {
+enum Implementation {
+#define IMPL_NO(_impl, _str) _impl,
+  IMPLEMENTATION_TABLE(IMPL_NO)
+#undef IMPL_NO
+};
+} // namespace simd
+
+inline const char *ImplementationStr(const simd::Implementation impl) {
+  const static char *impl_str_table[] = {
+#define IMPL_STR(_impl, _str) _str,
+      IMPLEMENTATION_TABLE(IMPL_STR)
+#undef IMPL_STR
+  };
+
+  NEUJSON_ASSERT(impl >= 0 && impl < NEUJSON_LENGTH(impl_str_table));
+  return impl_str_table[impl];
+}
+
+#undef IMPLEMENTATION_TABLE
+
+namespace internal {
+
+/**
+ * @brief Classes of the 64 bytes of a block, bit i standing for byte i.
+ */
+struct BlockMasks {
+  uint64_t quote;      // '"'
+  uint64_t backslash;  // '\\'
+  uint64_t op;         // '{', '}', '[', ']', ':' and ','
+  uint64_t whitespace; // ' ', '\n', '\r' and '\t'
+};
+
+/**
+ * @brief Hot loops of the parser and the writer. Every kernel works on
+ * [p, end) and only issues vector loads that end at or before end. The
+ * scanning ones return the position of the first byte they stopped at (end if
+ * none).
+ */
+struct Kernels {
+  simd::Implementation implementation;
+  // first byte which is not ' ', '\n', '\r' or '\t'
+  const char *(*skip_whitespace)(const char *p, const char *end);
+  // first '"', '\\' or control character, i.e. the next byte a string body
+  // can not copy verbatim, both when reading and when escaping for output
+  const char *(*scan_string)(const char *p, const char *end);
+  // whether the bytes are well-formed UTF-8
+  bool (*validate_utf8)(const char *p, const char *end);
+  // classes of the 64 bytes at p, the one kernel reading a fixed-size block
+  BlockMasks (*classify_block)(const char *p);
+};
+
+inline bool IsWhitespace(const char ch) {
+  return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+}
+
+inline bool IsStringSpecial(const char ch) {
+  return ch == '"' || ch == '\\' || static_cast<unsigned char>(ch) < 0x20;
+}
+
+inline const char *SkipWhitespaceScalar(const char *p, const char *end) {
+  while (p != end && IsWhitespace(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+inline const char *ScanStringScalar(const char *p, const char *end) {
+  while (p != end && !IsStringSpecial(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+/**
+ * @brief What a non-ASCII lead byte starts, see table 3-7 of the Unicode
+ * standard: the length of its sequence, 0 if it can not start one, and the
+ * range its second byte must fall in.
+ */
+struct Utf8Lead {
+  std::size_t length;
+  unsigned char lower;
+  unsigned char upper;
+};
+
+inline Utf8Lead DecodeUtf8Lead(const unsigned char lead) {
+  Utf8Lead result = {0, 0x80, 0xBF};
+  if (lead < 0xC2) {
+    return result;
+  } else if (lead < 0xE0) {
+    result.length = 2;
+  } else if (lead < 0xF0) {
+    result.length = 3;
+    result.lower = lead == 0xE0 ? 0xA0 : 0x80; // overlong
+    result.upper = lead == 0xED ? 0x9F : 0xBF; // surrogates
+  } else if (lead < 0xF5) {
+    result.length = 4;
+    result.lower = lead == 0xF0 ? 0x90 : 0x80; // overlong
+    result.upper = lead == 0xF4 ? 0x8F : 0xBF; // above U+10FFFF
+  }
+  return result;
+}
+
+/**
+ * @brief The byte at fault in the UTF-8 sequence at a non-ASCII byte, the
+ * first one a decoder reading left to right can tell is wrong.
+ * @param p
+ * @param end
+ * @return p for a bad lead byte, the bad continuation byte, end if the
+ * sequence is cut short by it, or null if the sequence is well-formed
+ */
+inline const char *Utf8SequenceFault(const char *p, const char *end) {
+  const Utf8Lead lead = DecodeUtf8Lead(static_cast<unsigned char>(*p));
+  if (lead.length == 0) {
+    return p;
+  }
+  for (std::size_t i = 1; i < lead.length; ++i) {
+    if (p + i == end) {
+      return end;
+    }
+    const auto byte = static_cast<unsigned char>(p[i]);
+    if (byte < (i == 1 ? lead.lower : 0x80) ||
+        byte > (i == 1 ? lead.upper : 0xBF)) {
+      return p + i;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Length of the well-formed UTF-8 sequence at a non-ASCII byte.
+ * @param p
+ * @param end
+ * @return 2 to 4, or 0 if the sequence is ill-formed or cut short by end
+ */
+inline std::size_t Utf8SequenceLength(const char *p, const char *end) {
+  if (Utf8SequenceFault(p, end) != nullptr) {
+    return 0;
+  }
+  return DecodeUtf8Lead(static_cast<unsigned char>(*p)).length;
+}
+
+/**
+ * @brief The first byte of [p, end) at fault, see Utf8SequenceFault, or null
+ * if all of it is well-formed UTF-8.
+ */
+inline const char *FindUtf8Fault(const char *p, const char *end) {
+  while (p != end) {
+    if (end - p >= 8) {
+      uint64_t chunk;
+      std::memcpy(&chunk, p, sizeof(chunk));
+      if ((chunk & 0x8080808080808080) == 0) {
+        p += 8;
+        continue;
+      } // eight ASCII characters at once
+    }
+    if (static_cast<unsigned char>(*p) < 0x80) {
+      ++p;
+      continue;
+    }
+    if (const char *fault = Utf8SequenceFault(p, end); fault != nullptr) {
+      return fault;
+    }
+    p += DecodeUtf8Lead(static_cast<unsigned char>(*p)).length;
+  }
+  return nullptr;
+}
+
+inline bool ValidateUtf8Scalar(const char *p, const char *end) {
+  return FindUtf8Fault(p, end) == nullptr;
+}
+
+inline BlockMasks ClassifyBlockScalar(const char *p) {
+  BlockMasks masks = {};
+  for (int i = 0; i < 64; ++i) {
+    const uint64_t bit = uint64_t{1} << i;
+    switch (p[i]) {
+    case '"':
+      masks.quote |= bit;
+      break;
+    case '\\':
+      masks.backslash |= bit;
+      break;
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+      masks.op |= bit;
+      break;
+    case ' ':
+    case '\n':
+    case '\r':
+    case '\t':
+      masks.whitespace |= bit;
+      break;
+    default:
+      break;
+    }
+  }
+  return masks;
+}
+
+// The vectorized UTF-8 check of Keiser & Lemire, "Validating UTF-8 In Less
+// Than One Instruction Per Byte": three 16-entry tables, indexed by the high
+// and low nibble of a byte and the high nibble of the next one, each give the
+// errors the pair could form; a bit set in all three is an error. Sequences of
+// three and four bytes additionally require continuations two and three bytes
+// after their lead.
+constexpr uint8_t kUtf8TooShort = 1 << 0;     // lead or ASCII, then a lead
+constexpr uint8_t kUtf8TooLong = 1 << 1;      // ASCII, then a continuation
+constexpr uint8_t kUtf8Overlong3 = 1 << 2;    // 11100000 100_____
+constexpr uint8_t kUtf8TooLarge = 1 << 3;     // 11110100 1001____ and above
+constexpr uint8_t kUtf8Surrogate = 1 << 4;    // 11101101 101_____
+constexpr uint8_t kUtf8Overlong2 = 1 << 5;    // 1100000_ 10______
+constexpr uint8_t kUtf8TooLarge1000 = 1 << 6; // 11110101 1000____ and above
+constexpr uint8_t kUtf8Overlong4 = 1 << 6;    // 11110000 1000____
+constexpr uint8_t kUtf8TwoConts = 1 << 7;     // continuation, continuation
+constexpr uint8_t kUtf8Carry = kUtf8TooShort | kUtf8TooLong | kUtf8TwoConts;
+
+inline constexpr uint8_t kUtf8Byte1High[16] = {
+    // 0_______ ASCII
+    kUtf8TooLong, kUtf8TooLong, kUtf8TooLong, kUtf8TooLong, kUtf8TooLong,
+    kUtf8TooLong, kUtf8TooLong, kUtf8TooLong,
+    // 10______ continuation
+    kUtf8TwoConts, kUtf8TwoConts, kUtf8TwoConts, kUtf8TwoConts,
+    // 1100____ 1101____ two byte lead
+    kUtf8TooShort | kUtf8Overlong2, kUtf8TooShort,
+    // 1110____ three byte lead
+    kUtf8TooShort | kUtf8Overlong3 | kUtf8Surrogate,
+    // 1111____ four byte lead
+    kUtf8TooShort | kUtf8TooLarge | kUtf8TooLarge1000 | kUtf8Overlong4};
+
+inline constexpr uint8_t kUtf8Byte1Low[16] = {
+    // ____0000
+    kUtf8Carry | kUtf8Overlong3 | kUtf8Overlong2 | kUtf8Overlong4,
+    // ____0001
+    kUtf8Carry | kUtf8Overlong2,
+    // ____001_
+    kUtf8Carry, kUtf8Carry,
+    // ____0100
+    kUtf8Carry | kUtf8TooLarge,
+    // ____0101 ____011_ ____1___, except ____1101
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    // ____1101
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000 | kUtf8Surrogate,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000,
+    kUtf8Carry | kUtf8TooLarge | kUtf8TooLarge1000};
+
+inline constexpr uint8_t kUtf8Byte2High[16] = {
+    // 0_______ ASCII
+    kUtf8TooShort, kUtf8TooShort, kUtf8TooShort, kUtf8TooShort, kUtf8TooShort,
+    kUtf8TooShort, kUtf8TooShort, kUtf8TooShort,
+    // 1000____
+    kUtf8TooLong | kUtf8Overlong2 | kUtf8TwoConts | kUtf8Overlong3 |
+        kUtf8TooLarge1000 | kUtf8Overlong4,
+    // 1001____
+    kUtf8TooLong | kUtf8Overlong2 | kUtf8TwoConts | kUtf8Overlong3 |
+        kUtf8TooLarge,
+    // 101_____
+    kUtf8TooLong | kUtf8Overlong2 | kUtf8TwoConts | kUtf8Surrogate |
+        kUtf8TooLarge,
+    kUtf8TooLong | kUtf8Overlong2 | kUtf8TwoConts | kUtf8Surrogate |
+        kUtf8TooLarge,
+    // 11______ lead
+    kUtf8TooShort, kUtf8TooShort, kUtf8TooShort, kUtf8TooShort};
+
+#if defined(NEUJSON_SIMD_X86)
+NEUJSON_TARGET("sse2")
+inline const char *SkipWhitespaceSSE2(const char *p, const char *end) {
+  const __m128i w0 = _mm_set1_epi8(' ');
+  const __m128i w1 = _mm_set1_epi8('\n');
+  const __m128i w2 = _mm_set1_epi8('\r');
+  const __m128i w3 = _mm_set1_epi8('\t');
+  for (; end - p >= 16; p += 16) {
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i x = _mm_cmpeq_epi8(s, w0);
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, w1));
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, w2));
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, w3));
+    // some characters are non-whitespace
+    if (const auto r = static_cast<uint16_t>(~_mm_movemask_epi8(x)); r != 0) {
+      return p + ctzll(r);
+    }
+  }
+  return SkipWhitespaceScalar(p, end);
+}
+
+NEUJSON_TARGET("sse2")
+inline const char *ScanStringSSE2(const char *p, const char *end) {
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1F);
+  for (; end - p >= 16; p += 16) {
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i x = _mm_cmpeq_epi8(s, quote);
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, backslash));
+    // s <= 0x1F unsigned
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(_mm_min_epu8(s, control), s));
+    if (const auto r = static_cast<uint16_t>(_mm_movemask_epi8(x)); r != 0) {
+      return p + ctzll(r);
+    }
+  }
+  return ScanStringScalar(p, end);
+}
+
+/**
+ * @brief Skip whitespace with SSE 4.2 pcmpistrm instruction, testing 16 8-byte
+ * characters at once.
+ */
+NEUJSON_TARGET("sse4.2")
+inline const char *SkipWhitespaceSSE42(const char *p, const char *end) {
+  static const char whitespace[16] = " \n\r\t";
+  const __m128i w =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(&whitespace[0]));
+  for (; end - p >= 16; p += 16) {
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    // a '\0' ends the implicit length string, and counts as non-whitespace
+    const int r =
+        _mm_cmpistri(w, s,
+                     _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY |
+                         _SIDD_LEAST_SIGNIFICANT | _SIDD_NEGATIVE_POLARITY);
+    if (r != 16) {
+      return p + r;
+    }
+  }
+  return SkipWhitespaceScalar(p, end);
+}
+
+NEUJSON_TARGET("sse4.2")
+inline const char *ScanStringSSE42(const char *p, const char *end) {
+  // ranges [0x00, 0x1F], ['"', '"'] and ['\\', '\\']
+  static const char ranges[16] = {'\0', '\x1F', '"', '"', '\\', '\\'};
+  const __m128i r =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(&ranges[0]));
+  for (; end - p >= 16; p += 16) {
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const int i = _mm_cmpestri(
+        r, 6, s, 16,
+        _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+    if (i != 16) {
+      return p + i;
+    }
+  }
+  return ScanStringScalar(p, end);
+}
+
+NEUJSON_TARGET("sse2")
+inline bool ValidateUtf8SSE2(const char *p, const char *end) {
+  while (end - p >= 16) {
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    if (const int m = _mm_movemask_epi8(s); m != 0) {
+      // no shuffles before SSSE3, check the sequence at the first non-ASCII
+      // byte on its own
+      p += ctzll(static_cast<uint32_t>(m));
+      const std::size_t length = Utf8SequenceLength(p, end);
+      if (length == 0) {
+        return false;
+      }
+      p += length;
+    } else {
+      p += 16;
+    }
+  }
+  return ValidateUtf8Scalar(p, end);
+}
+
+NEUJSON_TARGET("sse2")
+inline BlockMasks ClassifyBlockSSE2(const char *p) {
+  BlockMasks masks = {};
+  for (int i = 0; i < 64; i += 16) {
+    const __m128i s =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    // '[' and ']' are '{' and '}' with bit 5 cleared
+    const __m128i folded = _mm_or_si128(s, _mm_set1_epi8(0x20));
+    __m128i op = _mm_cmpeq_epi8(folded, _mm_set1_epi8('{'));
+    op = _mm_or_si128(op, _mm_cmpeq_epi8(folded, _mm_set1_epi8('}')));
+    op = _mm_or_si128(op, _mm_cmpeq_epi8(s, _mm_set1_epi8(':')));
+    op = _mm_or_si128(op, _mm_cmpeq_epi8(s, _mm_set1_epi8(',')));
+    __m128i ws = _mm_cmpeq_epi8(s, _mm_set1_epi8(' '));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(s, _mm_set1_epi8('\n')));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(s, _mm_set1_epi8('\r')));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(s, _mm_set1_epi8('\t')));
+    const __m128i quote = _mm_cmpeq_epi8(s, _mm_set1_epi8('"'));
+    const __m128i backslash = _mm_cmpeq_epi8(s, _mm_set1_epi8('\\'));
+    // the masks of 16 bytes are never negative
+    masks.quote |= static_cast<uint64_t>(_mm_movemask_epi8(quote)) << i;
+    masks.backslash |= static_cast<uint64_t>(_mm_movemask_epi8(backslash)) << i;
+    masks.op |= static_cast<uint64_t>(_mm_movemask_epi8(op)) << i;
+    masks.whitespace |= static_cast<uint64_t>(_mm_movemask_epi8(ws)) << i;
+  }
+  return masks;
+}
+
+/**
+ * @brief UTF-8 errors of a block given the block before it, non-zero bytes
+ * mark errors.
+ */
+NEUJSON_TARGET("sse4.2")
+inline __m128i Utf8ErrorsSSE42(const __m128i input, const __m128i prev_input) {
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  const __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+  const __m128i byte_1_high = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(kUtf8Byte1High)),
+      _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+  const __m128i byte_1_low = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(kUtf8Byte1Low)),
+      _mm_and_si128(prev1, nibble));
+  const __m128i byte_2_high = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(kUtf8Byte2High)),
+      _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+  const __m128i special =
+      _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+  // only 111_____ two bytes back and 1111____ three bytes back reach 0x80
+  const __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+  const __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+  const __m128i must_23 =
+      _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80)),
+                   _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0 - 0x80)));
+  return _mm_xor_si128(
+      _mm_and_si128(must_23, _mm_set1_epi8(static_cast<char>(0x80))), special);
+}
+
+NEUJSON_TARGET("sse4.2")
+inline bool ValidateUtf8SSE42(const char *p, const char *end) {
+  __m128i prev = _mm_setzero_si128();
+  __m128i error = _mm_setzero_si128();
+  for (; end - p >= 16; p += 16) {
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    // ASCII after ASCII can not be wrong
+    if ((_mm_movemask_epi8(s) | _mm_movemask_epi8(prev)) != 0) {
+      error = _mm_or_si128(error, Utf8ErrorsSSE42(s, prev));
+    }
+    prev = s;
+  }
+  // the tail padded with NULs, then a block of NULs, which fails sequences
+  // cut short by the end
+  char tail[16] = {};
+  std::memcpy(tail, p, static_cast<std::size_t>(end - p));
+  const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tail));
+  error = _mm_or_si128(error, Utf8ErrorsSSE42(s, prev));
+  error = _mm_or_si128(error, Utf8ErrorsSSE42(_mm_setzero_si128(), s));
+  return _mm_testz_si128(error, error) != 0;
+}
+
+NEUJSON_TARGET("avx2")
+inline const char *SkipWhitespaceAVX2(const char *p, const char *end) {
+  const __m256i w0 = _mm256_set1_epi8(' ');
+  const __m256i w1 = _mm256_set1_epi8('\n');
+  const __m256i w2 = _mm256_set1_epi8('\r');
+  const __m256i w3 = _mm256_set1_epi8('\t');
+  for (; end - p >= 32; p += 32) {
+    const __m256i s =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i x = _mm256_cmpeq_epi8(s, w0);
+    x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, w1));
+    x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, w2));
+    x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, w3));
+    if (const auto r = static_cast<uint32_t>(~_mm256_movemask_epi8(x));
+        r != 0) {
+      return p + ctzll(r);
+    }
+  }
+  return SkipWhitespaceSSE2(p, end);
+}
+
+NEUJSON_TARGET("avx2")
+inline const char *ScanStringAVX2(const char *p, const char *end) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i control = _mm256_set1_epi8(0x1F);
+  for (; end - p >= 32; p += 32) {
+    const __m256i s =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i x = _mm256_cmpeq_epi8(s, quote);
+    x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, backslash));
+    x = _mm256_or_si256(x, _mm256_cmpeq_epi8(_mm256_min_epu8(s, control), s));
+    if (const auto r = static_cast<uint32_t>(_mm256_movemask_epi8(x));
+        r != 0) {
+      return p + ctzll(r);
+    }
+  }
+  return ScanStringSSE2(p, end);
+}
+
+NEUJSON_TARGET("avx2")
+inline __m256i Utf8ErrorsAVX2(const __m256i input, const __m256i prev_input) {
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  // the previous bytes cross the 128-bit lanes
+  const __m256i carry = _mm256_permute2x128_si256(prev_input, input, 0x21);
+  const __m256i prev1 = _mm256_alignr_epi8(input, carry, 15);
+  const __m256i byte_1_high = _mm256_shuffle_epi8(
+      _mm256_broadcastsi128_si256(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(kUtf8Byte1High))),
+      _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+  const __m256i byte_1_low = _mm256_shuffle_epi8(
+      _mm256_broadcastsi128_si256(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(kUtf8Byte1Low))),
+      _mm256_and_si256(prev1, nibble));
+  const __m256i byte_2_high = _mm256_shuffle_epi8(
+      _mm256_broadcastsi128_si256(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(kUtf8Byte2High))),
+      _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+  const __m256i special = _mm256_and_si256(
+      _mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+  const __m256i prev2 = _mm256_alignr_epi8(input, carry, 14);
+  const __m256i prev3 = _mm256_alignr_epi8(input, carry, 13);
+  const __m256i must_23 =
+      _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80)),
+                      _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xF0 - 0x80)));
+  return _mm256_xor_si256(
+      _mm256_and_si256(must_23, _mm256_set1_epi8(static_cast<char>(0x80))),
+      special);
+}
+
+NEUJSON_TARGET("avx2")
+inline bool ValidateUtf8AVX2(const char *p, const char *end) {
+  __m256i prev = _mm256_setzero_si256();
+  __m256i error = _mm256_setzero_si256();
+  for (; end - p >= 32; p += 32) {
+    const __m256i s =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    if ((_mm256_movemask_epi8(s) | _mm256_movemask_epi8(prev)) != 0) {
+      error = _mm256_or_si256(error, Utf8ErrorsAVX2(s, prev));
+    }
+    prev = s;
+  }
+  char tail[32] = {};
+  std::memcpy(tail, p, static_cast<std::size_t>(end - p));
+  const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tail));
+  error = _mm256_or_si256(error, Utf8ErrorsAVX2(s, prev));
+  error = _mm256_or_si256(error, Utf8ErrorsAVX2(_mm256_setzero_si256(), s));
+  return _mm256_testz_si256(error, error) != 0;
+}
+
+NEUJSON_TARGET("avx2")
+inline BlockMasks ClassifyBlockAVX2(const char *p) {
+  BlockMasks masks = {};
+  for (int i = 0; i < 64; i += 32) {
+    const __m256i s =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    const __m256i folded = _mm256_or_si256(s, _mm256_set1_epi8(0x20));
+    __m256i op = _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{'));
+    op = _mm256_or_si256(op, _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}')));
+    op = _mm256_or_si256(op, _mm256_cmpeq_epi8(s, _mm256_set1_epi8(':')));
+    op = _mm256_or_si256(op, _mm256_cmpeq_epi8(s, _mm256_set1_epi8(',')));
+    __m256i ws = _mm256_cmpeq_epi8(s, _mm256_set1_epi8(' '));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\n')));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\r')));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\t')));
+    const __m256i quote = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('"'));
+    const __m256i backslash = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\\'));
+    masks.quote |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(quote))}
+                   << i;
+    masks.backslash |=
+        uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(backslash))} << i;
+    masks.op |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(op))} << i;
+    masks.whitespace |=
+        uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(ws))} << i;
+  }
+  return masks;
+}
+
+NEUJSON_TARGET("avx512f,avx512bw")
+inline const char *SkipWhitespaceAVX512(const char *p, const char *end) {
+  const __m512i w0 = _mm512_set1_epi8(' ');
+  const __m512i w1 = _mm512_set1_epi8('\n');
+  const __m512i w2 = _mm512_set1_epi8('\r');
+  const __m512i w3 = _mm512_set1_epi8('\t');
+  for (; end - p >= 64; p += 64) {
+    const __m512i s = _mm512_loadu_si512(p);
+    const uint64_t x =
+        _mm512_cmpeq_epi8_mask(s, w0) | _mm512_cmpeq_epi8_mask(s, w1) |
+        _mm512_cmpeq_epi8_mask(s, w2) | _mm512_cmpeq_epi8_mask(s, w3);
+    if (~x != 0) {
+      return p + ctzll(~x);
+    }
+  }
+  return SkipWhitespaceAVX2(p, end);
+}
+
+NEUJSON_TARGET("avx512f,avx512bw")
+inline const char *ScanStringAVX512(const char *p, const char *end) {
+  const __m512i quote = _mm512_set1_epi8('"');
+  const __m512i backslash = _mm512_set1_epi8('\\');
+  const __m512i control = _mm512_set1_epi8(0x1F);
+  for (; end - p >= 64; p += 64) {
+    const __m512i s = _mm512_loadu_si512(p);
+    const uint64_t x = _mm512_cmpeq_epi8_mask(s, quote) |
+                       _mm512_cmpeq_epi8_mask(s, backslash) |
+                       _mm512_cmple_epu8_mask(s, control);
+    if (x != 0) {
+      return p + ctzll(x);
+    }
+  }
+  return ScanStringAVX2(p, end);
+}
+
+NEUJSON_TARGET("avx512f,avx512bw")
+inline BlockMasks ClassifyBlockAVX512(const char *p) {
+  const __m512i s = _mm512_loadu_si512(p);
+  const __m512i folded = _mm512_or_si512(s, _mm512_set1_epi8(0x20));
+  BlockMasks masks;
+  masks.quote = _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('"'));
+  masks.backslash = _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\\'));
+  masks.op = _mm512_cmpeq_epi8_mask(folded, _mm512_set1_epi8('{')) |
+             _mm512_cmpeq_epi8_mask(folded, _mm512_set1_epi8('}')) |
+             _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8(':')) |
+             _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8(','));
+  masks.whitespace = _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8(' ')) |
+                     _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\n')) |
+                     _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\r')) |
+                     _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\t'));
+  return masks;
+}
+#elif defined(NEUJSON_SIMD_NEON)
+/**
+ * @brief Index of the first non-zero byte of a comparison result, narrowed
+ * to four bits per byte.
+ */
+inline uint32_t FirstSetNEON(const uint8x16_t x) {
+  const uint64_t m = vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(x), 4)), 0);
+  return ctzll(m) >> 2;
+}
+
+inline const char *SkipWhitespaceNEON(const char *p, const char *end) {
+  const uint8x16_t w0 = vmovq_n_u8(' ');
+  const uint8x16_t w1 = vmovq_n_u8('\n');
+  const uint8x16_t w2 = vmovq_n_u8('\r');
+  const uint8x16_t w3 = vmovq_n_u8('\t');
+  for (; end - p >= 16; p += 16) {
+    const uint8x16_t s = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+    uint8x16_t x = vceqq_u8(s, w0);
+    x = vorrq_u8(x, vceqq_u8(s, w1));
+    x = vorrq_u8(x, vceqq_u8(s, w2));
+    x = vorrq_u8(x, vceqq_u8(s, w3));
+    x = vmvnq_u8(x);
+    if (vmaxvq_u8(x) != 0) {
+      return p + FirstSetNEON(x);
+    }
+  }
+  return SkipWhitespaceScalar(p, end);
+}
+
+inline const char *ScanStringNEON(const char *p, const char *end) {
+  const uint8x16_t quote = vmovq_n_u8('"');
+  const uint8x16_t backslash = vmovq_n_u8('\\');
+  const uint8x16_t control = vmovq_n_u8(0x1F);
+  for (; end - p >= 16; p += 16) {
+    const uint8x16_t s = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+    uint8x16_t x = vceqq_u8(s, quote);
+    x = vorrq_u8(x, vceqq_u8(s, backslash));
+    x = vorrq_u8(x, vcleq_u8(s, control));
+    if (vmaxvq_u8(x) != 0) {
+      return p + FirstSetNEON(x);
+    }
+  }
+  return ScanStringScalar(p, end);
+}
+
+inline uint8x16_t Utf8ErrorsNEON(const uint8x16_t input,
+                                 const uint8x16_t prev_input) {
+  const uint8x16_t prev1 = vextq_u8(prev_input, input, 15);
+  const uint8x16_t byte_1_high =
+      vqtbl1q_u8(vld1q_u8(kUtf8Byte1High), vshrq_n_u8(prev1, 4));
+  const uint8x16_t byte_1_low =
+      vqtbl1q_u8(vld1q_u8(kUtf8Byte1Low), vandq_u8(prev1, vmovq_n_u8(0x0F)));
+  const uint8x16_t byte_2_high =
+      vqtbl1q_u8(vld1q_u8(kUtf8Byte2High), vshrq_n_u8(input, 4));
+  const uint8x16_t special =
+      vandq_u8(vandq_u8(byte_1_high, byte_1_low), byte_2_high);
+
+  const uint8x16_t prev2 = vextq_u8(prev_input, input, 14);
+  const uint8x16_t prev3 = vextq_u8(prev_input, input, 13);
+  const uint8x16_t must_23 =
+      vorrq_u8(vqsubq_u8(prev2, vmovq_n_u8(0xE0 - 0x80)),
+               vqsubq_u8(prev3, vmovq_n_u8(0xF0 - 0x80)));
+  return veorq_u8(vandq_u8(must_23, vmovq_n_u8(0x80)), special);
+}
+
+inline bool ValidateUtf8NEON(const char *p, const char *end) {
+  uint8x16_t prev = vmovq_n_u8(0);
+  uint8x16_t error = vmovq_n_u8(0);
+  for (; end - p >= 16; p += 16) {
+    const uint8x16_t s = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+    if (vmaxvq_u8(vorrq_u8(s, prev)) >= 0x80) {
+      error = vorrq_u8(error, Utf8ErrorsNEON(s, prev));
+    }
+    prev = s;
+  }
+  uint8_t tail[16] = {};
+  std::memcpy(tail, p, static_cast<std::size_t>(end - p));
+  const uint8x16_t s = vld1q_u8(tail);
+  error = vorrq_u8(error, Utf8ErrorsNEON(s, prev));
+  error = vorrq_u8(error, Utf8ErrorsNEON(vmovq_n_u8(0), s));
+  return vmaxvq_u8(error) == 0;
+}
+
+/**
+ * @brief One bit per byte of four comparison results, folded by pairwise
+ * additions of the bytes' weights.
+ */
+inline uint64_t MovemaskNEON(const uint8x16_t m0, const uint8x16_t m1,
+                             const uint8x16_t m2, const uint8x16_t m3) {
+  static constexpr uint8_t kWeights[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                           1, 2, 4, 8, 16, 32, 64, 128};
+  const uint8x16_t weights = vld1q_u8(kWeights);
+  const uint8x16_t s0 =
+      vpaddq_u8(vandq_u8(m0, weights), vandq_u8(m1, weights));
+  const uint8x16_t s1 =
+      vpaddq_u8(vandq_u8(m2, weights), vandq_u8(m3, weights));
+  uint8x16_t s = vpaddq_u8(s0, s1);
+  s = vpaddq_u8(s, s);
+  return vgetq_lane_u64(vreinterpretq_u64_u8(s), 0);
+}
+
+inline BlockMasks ClassifyBlockNEON(const char *p) {
+  uint8x16_t quote[4];
+  uint8x16_t backslash[4];
+  uint8x16_t op[4];
+  uint8x16_t ws[4];
+  for (int i = 0; i < 4; ++i) {
+    const uint8x16_t s =
+        vld1q_u8(reinterpret_cast<const uint8_t *>(p) + 16 * i);
+    const uint8x16_t folded = vorrq_u8(s, vmovq_n_u8(0x20));
+    quote[i] = vceqq_u8(s, vmovq_n_u8('"'));
+    backslash[i] = vceqq_u8(s, vmovq_n_u8('\\'));
+    op[i] = vorrq_u8(vorrq_u8(vceqq_u8(folded, vmovq_n_u8('{')),
+                              vceqq_u8(folded, vmovq_n_u8('}'))),
+                     vorrq_u8(vceqq_u8(s, vmovq_n_u8(':')),
+                              vceqq_u8(s, vmovq_n_u8(','))));
+    ws[i] = vorrq_u8(vorrq_u8(vceqq_u8(s, vmovq_n_u8(' ')),
+                              vceqq_u8(s, vmovq_n_u8('\n'))),
+                     vorrq_u8(vceqq_u8(s, vmovq_n_u8('\r')),
+                              vceqq_u8(s, vmovq_n_u8('\t'))));
+  }
+  BlockMasks masks;
+  masks.quote = MovemaskNEON(quote[0], quote[1], quote[2], quote[3]);
+  masks.backslash =
+      MovemaskNEON(backslash[0], backslash[1], backslash[2], backslash[3]);
+  masks.op = MovemaskNEON(op[0], op[1], op[2], op[3]);
+  masks.whitespace = MovemaskNEON(ws[0], ws[1], ws[2], ws[3]);
+  return masks;
+}
+#endif
+
+#if defined(NEUJSON_SIMD_X86)
+inline void CpuId(const unsigned leaf, const unsigned sub_leaf,
+                  unsigned regs[4]) {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuidex(info, static_cast<int>(leaf), static_cast<int>(sub_leaf));
+  for (int i = 0; i < 4; ++i) {
+    regs[i] = static_cast<unsigned>(info[i]);
+  }
+#else
+  regs[0] = regs[1] = regs[2] = regs[3] = 0;
+  __cpuid_count(leaf, sub_leaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// register state the OS saves on context switch (XCR0)
+inline uint64_t XGetBv() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+/**
+ * @brief Whether the running CPU (and OS) can execute the implementation.
+ */
+inline bool CpuSupports(const simd::Implementation impl) {
+  switch (impl) {
+  case simd::SCALAR:
+    return true;
+#if defined(NEUJSON_SIMD_X86)
+  case simd::SSE2:
+  case simd::SSE42:
+  case simd::AVX2:
+  case simd::AVX512: {
+    unsigned leaf1[4], leaf7[4] = {0, 0, 0, 0};
+    CpuId(0, 0, leaf1);
+    const unsigned max_leaf = leaf1[0];
+    CpuId(1, 0, leaf1);
+    if (max_leaf >= 7) {
+      CpuId(7, 0, leaf7);
+    }
+    const bool sse2 = (leaf1[3] >> 26) & 1;
+    const bool sse42 = (leaf1[2] >> 20) & 1;
+    const bool os_xsave = (leaf1[2] >> 27) & 1;
+    const bool avx = (leaf1[2] >> 28) & 1;
+    const uint64_t xcr0 = os_xsave ? XGetBv() : 0;
+    const bool os_ymm = (xcr0 & 0x6) == 0x6;
+    const bool os_zmm = (xcr0 & 0xE6) == 0xE6;
+    const bool avx2 = (leaf7[1] >> 5) & 1;
+    const bool avx512f = (leaf7[1] >> 16) & 1;
+    const bool avx512bw = (leaf7[1] >> 30) & 1;
+    switch (impl) {
+    case simd::SSE2:
+      return sse2;
+    case simd::SSE42:
+      return sse2 && sse42;
+    case simd::AVX2:
+      return sse2 && avx && avx2 && os_ymm;
+    default:
+      return sse2 && avx && avx2 && avx512f && avx512bw && os_zmm;
+    }
+  }
+#elif defined(NEUJSON_SIMD_NEON)
+  // Advanced SIMD is mandatory on AArch64, no getauxval() probe needed
+  case simd::NEON:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief Kernels of one implementation, the scalar ones if it is not built for
+ * the target architecture.
+ */
+inline const Kernels &GetKernels(const simd::Implementation impl) {
+  static constexpr Kernels kScalar = {simd::SCALAR, SkipWhitespaceScalar,
+                                      ScanStringScalar, ValidateUtf8Scalar,
+                                      ClassifyBlockScalar};
+#if defined(NEUJSON_SIMD_X86)
+  static constexpr Kernels kSSE2 = {simd::SSE2, SkipWhitespaceSSE2,
+                                    ScanStringSSE2, ValidateUtf8SSE2,
+                                    ClassifyBlockSSE2};
+  // pcmpistrm would not beat four plain compares on fixed blocks
+  static constexpr Kernels kSSE42 = {simd::SSE42, SkipWhitespaceSSE42,
+                                     ScanStringSSE42, ValidateUtf8SSE42,
+                                     ClassifyBlockSSE2};
+  static constexpr Kernels kAVX2 = {simd::AVX2, SkipWhitespaceAVX2,
+                                    ScanStringAVX2, ValidateUtf8AVX2,
+                                    ClassifyBlockAVX2};
+  // the lookups gain nothing from wider registers, keep the AVX2 kernel
+  static constexpr Kernels kAVX512 = {simd::AVX512, SkipWhitespaceAVX512,
+                                      ScanStringAVX512, ValidateUtf8AVX2,
+                                      ClassifyBlockAVX512};
+  switch (impl) {
+  case simd::SSE2:
+    return kSSE2;
+  case simd::SSE42:
+    return kSSE42;
+  case simd::AVX2:
+    return kAVX2;
+  case simd::AVX512:
+    return kAVX512;
+  default:
+    return kScalar;
+  }
+#elif defined(NEUJSON_SIMD_NEON)
+  static constexpr Kernels kNEON = {simd::NEON, SkipWhitespaceNEON,
+                                    ScanStringNEON, ValidateUtf8NEON,
+                                    ClassifyBlockNEON};
+  return impl == simd::NEON ? kNEON : kScalar;
+#else
+  (void)impl;
+  return kScalar;
+#endif
+}
+
+/**
+ * @brief The best implementation for the running CPU.
+ */
+inline simd::Implementation DetectImplementation() {
+  for (const auto impl : {simd::AVX512, simd::AVX2, simd::SSE42, simd::SSE2,
+                          simd::NEON}) {
+    if (CpuSupports(impl)) {
+      return impl;
+    }
+  }
+  return simd::SCALAR;
+}
+
+/**
+ * @brief Kernels selected on first use, CPU features are probed only once.
+ */
+inline const Kernels &ActiveKernels() {
+  static const Kernels &kernels = GetKernels(DetectImplementation());
+  return kernels;
+}
+
+inline const char *SkipWhitespace(const char *p, const char *end) {
+  return ActiveKernels().skip_whitespace(p, end);
+}
+
+inline const char *ScanString(const char *p, const char *end) {
+  return ActiveKernels().scan_string(p, end);
+}
+
+/**
+ * @brief The first byte of [p, end) at fault, or null if it is well-formed
+ * UTF-8. The kernels only tell whether there is a fault, so a run they reject
+ * is walked again to find it; short runs such as most keys stay with the
+ * inlined scalar walk throughout.
+ */
+inline const char *ValidateUtf8(const char *p, const char *end) {
+  if (end - p >= 16 && ActiveKernels().validate_utf8(p, end)) {
+    return nullptr;
+  }
+  return FindUtf8Fault(p, end);
+}
+
+} // namespace internal
+
+/**
+ * @brief The SIMD implementation picked for this CPU.
+ */
+inline simd::Implementation GetActiveImplementation() {
+  return internal::ActiveKernels().implementation;
+}
+
+} // namespace neujson
+
+#endif // NEUJSON_INCLUDE_NEUJSON_INTERNAL_SIMD_H_
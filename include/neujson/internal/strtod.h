@@ -5,23 +5,66 @@
 #ifndef NEUJSON_INCLUDE_NEUJSON_INTERNAL_STRTOD_H_
 #define NEUJSON_INCLUDE_NEUJSON_INTERNAL_STRTOD_H_
 
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <string_view>
+
+#include "big_integer.h"
 #include "diy_fp.h"
 #include "ieee754.h"
 #include "pow10.h"
 
 namespace neujson::internal {
 
+// significant decimal digits that always fit in an uint64_t
+constexpr int kMaxSignificantDigits = 19;
+
+// enough for the exact value of every halfway point between two doubles
+constexpr int kMaxDecimalDigits = 768;
+
+/**
+ * @brief Append a digit to a decimal exponent. Past 10^8 the exponent stops
+ * growing: any number beyond that either overflows or underflows.
+ * @param exp
+ * @param ch '0'..'9'
+ * @return
+ */
+inline int64_t AppendExponentDigit(const int64_t exp, const char ch) {
+  return exp < 100000000 ? exp * 10 + (ch - '0') : exp;
+}
+
 inline double FastPath(const double fraction, const int exponent) {
   if (exponent < -308) {
     return 0.0;
   } else if (exponent >= 0) {
     return fraction * Pow10(exponent);
   } else {
-    return fraction * Pow10(-exponent);
+    return fraction / Pow10(-exponent);
   }
 }
 
-inline double StrTodNormalPrecision(double d, int p) {
+/**
+ * @brief Fast conversion of a JSON number split like for
+ * StrtodFullPrecision(), scaling the significand by at most two inexact powers
+ * of ten. The result may be off by a few ulp.
+ * @param significand first (at most 19) significant digits
+ * @param digits decimal digits of significand
+ * @param exp decimal exponent of significand
+ * @return the absolute value, infinity on overflow
+ */
+inline double StrtodNormalPrecision(const uint64_t significand,
+                                    const int digits, const int64_t exp) {
+  if (significand == 0 || digits + exp <= -324) {
+    return 0.0;
+  }
+  if (digits + exp > 309) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  double d = static_cast<double>(significand);
+  const int p = static_cast<int>(exp);
   if (p < -308) {
     d = FastPath(d, -308);
     d = FastPath(d, p + 308);
@@ -31,6 +74,310 @@ inline double StrTodNormalPrecision(double d, int p) {
   return d;
 }
 
+/**
+ * @brief Clinger's fast path: an integer below 2^53 and a power of ten up to
+ * 10^22 are both exact doubles, so a single IEEE operation rounds correctly.
+ * @param d integral significand
+ * @param p decimal exponent
+ * @param result d * 10^p on success
+ * @return
+ */
+inline bool StrtodFast(double d, int p, double *result) {
+  if (p > 22 && p < 22 + 16) {
+    // exact as long as d stays below 2^53, checked right below
+    d *= Pow10(p - 22);
+    p = 22;
+  }
+
+  if (p >= -22 && p <= 22 && d <= 9007199254740991.0) { // 2^53 - 1
+    *result = FastPath(d, p);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Compute significand * 10^exp with a 64-bit DiyFp while tracking the
+ * error bound, see Florian Loitsch's Grisu paper. Fails whenever the bound
+ * straddles the rounding boundary.
+ * @param significand first significant digits, rounded when truncated
+ * @param digits decimal digits of significand
+ * @param exp decimal exponent
+ * @param truncated whether digits were dropped after significand
+ * @param result the rounded approximation, even on failure
+ * @return whether result is correctly rounded
+ */
+inline bool StrtodDiyFp(const uint64_t significand, const int digits,
+                        const int exp, const bool truncated, double *result) {
+  static constexpr int kUlpShift = 3;
+  static constexpr int kUlp = 1 << kUlpShift;
+  int64_t error = truncated ? kUlp / 2 : 0;
+
+  DiyFp v = DiyFp(significand, 0).Normalize();
+  error <<= -v.e_;
+
+  int actual_exp;
+  const DiyFp cached_power = GetCachedPower10(exp, &actual_exp);
+  if (actual_exp != exp) {
+    static const DiyFp kPow10[] = {
+        DiyFp(NEUJSON_UINT64_C2(0xa0000000, 0x00000000), -60), // 10^1
+        DiyFp(NEUJSON_UINT64_C2(0xc8000000, 0x00000000), -57), // 10^2
+        DiyFp(NEUJSON_UINT64_C2(0xfa000000, 0x00000000), -54), // 10^3
+        DiyFp(NEUJSON_UINT64_C2(0x9c400000, 0x00000000), -50), // 10^4
+        DiyFp(NEUJSON_UINT64_C2(0xc3500000, 0x00000000), -47), // 10^5
+        DiyFp(NEUJSON_UINT64_C2(0xf4240000, 0x00000000), -44), // 10^6
+        DiyFp(NEUJSON_UINT64_C2(0x98968000, 0x00000000), -40)  // 10^7
+    };
+    const int adjustment = exp - actual_exp;
+    NEUJSON_ASSERT(adjustment >= 1 && adjustment < 8);
+    v = v * kPow10[adjustment - 1];
+    if (digits + adjustment > kMaxSignificantDigits) {
+      error += kUlp / 2;
+    } // the product no longer fits in 64 bits
+  }
+
+  v = v * cached_power;
+  error += kUlp + (error == 0 ? 0 : 1);
+
+  const int old_exp = v.e_;
+  v = v.Normalize();
+  error <<= old_exp - v.e_;
+
+  const int effective_significand_size =
+      Double::EffectiveSignificandSize(64 + v.e_);
+  int precision_size = 64 - effective_significand_size;
+  if (precision_size + kUlpShift >= 64) {
+    const int scale_exp = (precision_size + kUlpShift) - 63;
+    v.f_ >>= scale_exp;
+    v.e_ += scale_exp;
+    error = (error >> scale_exp) + 1 + kUlp;
+    precision_size -= scale_exp;
+  }
+
+  DiyFp rounded(v.f_ >> precision_size, v.e_ + precision_size);
+  const uint64_t precision_bits =
+      (v.f_ & ((static_cast<uint64_t>(1) << precision_size) - 1)) * kUlp;
+  const uint64_t half_way =
+      (static_cast<uint64_t>(1) << (precision_size - 1)) * kUlp;
+  const auto u_error = static_cast<uint64_t>(error);
+  if (precision_bits >= half_way + u_error) {
+    rounded.f_++;
+    if (rounded.f_ & (DiyFp::kDpHiddenBit << 1)) {
+      rounded.f_ >>= 1;
+      rounded.e_++;
+    } // rounding overflows the significand
+  }
+
+  *result = rounded.ToDouble();
+
+  return half_way - u_error >= precision_bits ||
+         precision_bits >= half_way + u_error;
+}
+
+/**
+ * @brief Compare the distance between b and the exact value d * 10^exp with
+ * half an ulp of b, all scaled to big integers.
+ * @param b
+ * @param d
+ * @param exp
+ * @param below whether the exact value is less than b
+ * @return <0, 0, >0 as the distance is less than, equal to or greater than
+ * half an ulp
+ */
+inline int CheckWithinHalfUlp(const double b, const BigInteger &d,
+                              const int exp, bool *below) {
+  const Double db(b);
+  const uint64_t b_int = db.IntegerSignificand();
+  const int b_exp = db.IntegerExponent();
+  const int h_exp = b_exp - 1;
+
+  int ds_exp2 = 0;
+  int ds_exp5 = 0;
+  int bs_exp2 = 0;
+  int bs_exp5 = 0;
+  int hs_exp2 = 0;
+  int hs_exp5 = 0;
+
+  // adjust for decimal exponent
+  if (exp >= 0) {
+    ds_exp2 += exp;
+    ds_exp5 += exp;
+  } else {
+    bs_exp2 -= exp;
+    bs_exp5 -= exp;
+    hs_exp2 -= exp;
+    hs_exp5 -= exp;
+  }
+
+  // adjust for binary exponent
+  if (b_exp >= 0) {
+    bs_exp2 += b_exp;
+  } else {
+    ds_exp2 -= b_exp;
+    hs_exp2 -= b_exp;
+  }
+
+  // adjust for half ulp exponent
+  if (h_exp >= 0) {
+    hs_exp2 += h_exp;
+  } else {
+    ds_exp2 -= h_exp;
+    bs_exp2 -= h_exp;
+  }
+
+  // remove common power of two factor from all three scaled values
+  const int common_exp2 = (std::min)(ds_exp2, (std::min)(bs_exp2, hs_exp2));
+  ds_exp2 -= common_exp2;
+  bs_exp2 -= common_exp2;
+  hs_exp2 -= common_exp2;
+
+  BigInteger ds = d;
+  ds.MultiplyPow5(static_cast<unsigned>(ds_exp5)) <<=
+      static_cast<std::size_t>(ds_exp2);
+
+  BigInteger bs(b_int);
+  bs.MultiplyPow5(static_cast<unsigned>(bs_exp5)) <<=
+      static_cast<std::size_t>(bs_exp2);
+
+  BigInteger hs(1);
+  hs.MultiplyPow5(static_cast<unsigned>(hs_exp5)) <<=
+      static_cast<std::size_t>(hs_exp2);
+
+  BigInteger delta(0);
+  *below = ds.Difference(bs, &delta);
+
+  // right below a power of two the ulp is only half as wide
+  if (*below && db.Fraction() == 0 && b_exp > -1074) {
+    delta <<= 1;
+  }
+
+  return delta.Compare(hs);
+}
+
+/**
+ * @brief Settle the approximation from StrtodDiyFp() by comparing it with the
+ * exact decimal value, which is off by at most one ulp.
+ * @param approx
+ * @param decimals significant digits, without leading or trailing zeros
+ * @param length
+ * @param exp decimal exponent of the last digit
+ * @param truncated whether non-zero digits were dropped after the last one
+ * @return
+ */
+inline double StrtodBigInteger(const double approx, const char *decimals,
+                               const int length, const int exp,
+                               const bool truncated) {
+  NEUJSON_ASSERT(length > 0 && length <= kMaxDecimalDigits);
+  Double a(approx);
+  if (a.IsZero()) {
+    a = Double(static_cast<uint64_t>(1));
+  } else if (a.IsInf()) {
+    a = Double(std::numeric_limits<double>::max());
+  } // only compare against finite, non-zero candidates
+
+  const BigInteger d(decimals, static_cast<std::size_t>(length));
+  bool below;
+  const int cmp = CheckWithinHalfUlp(a.Value(), d, exp, &below);
+  if (cmp < 0) {
+    return a.Value();
+  }
+  if (cmp == 0) {
+    if (truncated) {
+      // just past the halfway point, towards a when below it
+      return below ? a.Value() : a.NextPositiveDouble();
+    }
+    // halfway, round to even
+    if ((a.Fraction() & 1) == 0) {
+      return a.Value();
+    }
+  }
+  return below ? a.PrevPositiveDouble() : a.NextPositiveDouble();
+}
+
+/**
+ * @brief Correctly rounded conversion of a JSON number, which the Reader has
+ * already validated and split into significand and exponent. Everything
+ * happens on the stack; the number text is only read again for the rare
+ * inputs that need the BigInteger comparison.
+ * @param significand first (at most 19) significant digits, rounded by the
+ * next digit when truncated
+ * @param digits decimal digits of significand
+ * @param exp decimal exponent of significand
+ * @param truncated whether digits were dropped after significand
+ * @param number the whole number text
+ * @return the absolute value, infinity on overflow
+ */
+inline double StrtodFullPrecision(const uint64_t significand, const int digits,
+                                  const int64_t exp, const bool truncated,
+                                  const std::string_view number) {
+  if (significand == 0) {
+    return 0.0;
+  }
+  // any x >= 10^309 is infinity, any x <= 10^-324 is zero
+  if (digits + exp > 309) {
+    return std::numeric_limits<double>::infinity();
+  }
+  if (digits + exp <= -324) {
+    return 0.0;
+  }
+
+  const int p = static_cast<int>(exp);
+  double result = 0.0;
+  if (!truncated && StrtodFast(static_cast<double>(significand), p, &result)) {
+    return result;
+  }
+  if (StrtodDiyFp(significand, digits, p, truncated, &result)) {
+    return result;
+  }
+
+  // collect the significant digits, beyond kMaxDecimalDigits they can only
+  // break a tie
+  char decimals[kMaxDecimalDigits];
+  int length = 0;
+  int64_t d_exp = 0;
+  bool dropped = false;
+  bool fraction = false;
+  std::size_t i = number[0] == '-' ? 1 : 0;
+  for (; i < number.size(); i++) {
+    const char ch = number[i];
+    if (ch == '.') {
+      fraction = true;
+      continue;
+    }
+    if (ch == 'e' || ch == 'E') {
+      break;
+    }
+    if (fraction) {
+      d_exp--;
+    }
+    if (length == 0 && ch == '0') {
+      continue;
+    }
+    if (length < kMaxDecimalDigits) {
+      decimals[length++] = ch;
+    } else {
+      d_exp++;
+      dropped |= ch != '0';
+    }
+  }
+  if (i < number.size()) {
+    const bool minus = number[++i] == '-';
+    i += number[i] == '-' || number[i] == '+';
+    int64_t e = 0;
+    for (; i < number.size(); i++) {
+      e = AppendExponentDigit(e, number[i]);
+    }
+    d_exp += minus ? -e : e;
+  }
+  while (length > 0 && decimals[length - 1] == '0') {
+    length--;
+    d_exp++;
+  }
+
+  return StrtodBigInteger(result, decimals, length, static_cast<int>(d_exp),
+                          dropped);
+}
+
 } // namespace neujson::internal
 
 #endif // NEUJSON_INCLUDE_NEUJSON_INTERNAL_STRTOD_H_
@@ -0,0 +1,117 @@
+#ifndef NEUJSON_INCLUDE_NEUJSON_INTERNAL_STRUCTURAL_INDEX_H_
+#define NEUJSON_INCLUDE_NEUJSON_INTERNAL_STRUCTURAL_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "cllzl.h"
+#include "simd.h"
+
+namespace neujson::internal {
+
+/**
+ * @brief Running xor of the bits from bit 0 up, which turns the mask of the
+ * quotes opening and closing strings into the mask of the string bodies.
+ */
+inline uint64_t PrefixXor(uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+/**
+ * @brief Stage one of the StructuralReader. Classifies the input 64 bytes at a
+ * time with bit operations on the masks of internal::Kernels::classify_block,
+ * carrying the state across blocks in three words, and records the offset of
+ * every structural position: each '{', '}', '[', ']', ':' and ',' outside of
+ * strings, each quote opening a string and the first byte of every other
+ * token. Bytes inside strings and whitespace never show up, so the second
+ * stage steps from token to token without looking at them.
+ */
+class StructuralIndexer {
+  // 1 if the first byte of the next block is escaped by a backslash
+  uint64_t prev_escaped_ = 0;
+  // all ones if the next block starts inside a string
+  uint64_t prev_in_string_ = 0;
+  // 1 if the last byte of the previous block belongs to a literal or number
+  uint64_t prev_scalar_ = 0;
+
+public:
+  /**
+   * @brief Index the whole input.
+   * @param begin
+   * @param end
+   * @param index room for end - begin offsets
+   * @return the number of offsets written, in increasing order
+   */
+  std::size_t Index(const char *begin, const char *end, uint32_t *index) {
+    const Kernels &kernels = ActiveKernels();
+    uint32_t *out = index;
+    const char *p = begin;
+    for (; end - p >= 64; p += 64) {
+      out = Flatten(Structurals(kernels.classify_block(p)),
+                    static_cast<uint32_t>(p - begin), out);
+    }
+    if (p != end) {
+      // whitespace is neither structural nor part of a token
+      char tail[64];
+      std::memset(tail, ' ', sizeof(tail));
+      std::memcpy(tail, p, static_cast<std::size_t>(end - p));
+      out = Flatten(Structurals(kernels.classify_block(tail)),
+                    static_cast<uint32_t>(p - begin), out);
+    }
+    return static_cast<std::size_t>(out - index);
+  }
+
+private:
+  /**
+   * @brief The bytes escaped by a backslash: every other byte of a run of
+   * backslashes, starting from the second, and the byte after a run of odd
+   * length. Adding the odd-positioned run starts to the backslash mask carries
+   * those runs out, which flips the parity for them only.
+   */
+  uint64_t Escaped(uint64_t backslash) {
+    constexpr uint64_t kEvenBits = 0x5555555555555555;
+    // an escaped backslash starts nothing
+    backslash &= ~prev_escaped_;
+    const uint64_t follows_escape = backslash << 1 | prev_escaped_;
+    const uint64_t odd_starts = backslash & ~kEvenBits & ~follows_escape;
+    const uint64_t even_runs = odd_starts + backslash;
+    // the carry out of bit 63 is a run of odd length ending the block
+    prev_escaped_ = even_runs < backslash ? 1 : 0;
+    return (kEvenBits ^ (even_runs << 1)) & follows_escape;
+  }
+
+  uint64_t Structurals(const BlockMasks &masks) {
+    const uint64_t quote = masks.quote & ~Escaped(masks.backslash);
+    const uint64_t in_string = PrefixXor(quote) ^ prev_in_string_;
+    prev_in_string_ = 0 - (in_string >> 63);
+    // string bodies and their closing quotes, but not the opening ones
+    const uint64_t string_tail = in_string ^ quote;
+
+    // a token starts at a byte which is neither whitespace nor structural and
+    // follows none of its own, quotes do not glue to what comes after them
+    const uint64_t scalar = ~(masks.op | masks.whitespace);
+    const uint64_t nonquote_scalar = scalar & ~quote;
+    const uint64_t follows_scalar = nonquote_scalar << 1 | prev_scalar_;
+    prev_scalar_ = nonquote_scalar >> 63;
+    return (masks.op | (scalar & ~follows_scalar)) & ~string_tail;
+  }
+
+  static uint32_t *Flatten(uint64_t bits, const uint32_t base, uint32_t *out) {
+    while (bits != 0) {
+      *out++ = base + ctzll(bits);
+      bits &= bits - 1;
+    }
+    return out;
+  }
+};
+
+} // namespace neujson::internal
+
+#endif // NEUJSON_INCLUDE_NEUJSON_INTERNAL_STRUCTURAL_INDEX_H_
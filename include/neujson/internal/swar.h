@@ -0,0 +1,54 @@
+#ifndef NEUJSON_NEUJSON_INTERNAL_SWAR_H_
+#define NEUJSON_NEUJSON_INTERNAL_SWAR_H_
+
+#include <cstdint>
+#include <cstring>
+
+#include <bit>
+
+#include "neujson/neujson.h"
+
+namespace neujson::internal {
+
+/**
+ * @brief Load eight characters as one little-endian word, so the first
+ * character always lands in the lowest byte.
+ * @param p at least 8 readable bytes
+ * @return
+ */
+inline uint64_t LoadEightChars(const char *p) {
+  uint64_t val;
+  if constexpr (std::endian::native == std::endian::little) {
+    std::memcpy(&val, p, sizeof(val));
+  } else {
+    val = 0;
+    for (int i = 7; i >= 0; i--) {
+      val = val << 8 | static_cast<unsigned char>(p[i]);
+    }
+  }
+  return val;
+}
+
+/**
+ * @brief Whether all eight characters of val are in '0'..'9'.
+ */
+inline bool IsEightDigits(const uint64_t val) {
+  return ((val & 0xF0F0F0F0F0F0F0F0) |
+          (((val + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+         0x3333333333333333;
+}
+
+/**
+ * @brief Value of eight decimal digits loaded by LoadEightChars(), by merging
+ * neighbouring digits pairwise: 1 -> 2 -> 4 -> 8 digits.
+ */
+inline uint32_t ParseEightDigits(uint64_t val) {
+  val = (val & 0x0F0F0F0F0F0F0F0F) * 2561 >> 8;
+  val = (val & 0x00FF00FF00FF00FF) * 6553601 >> 16;
+  return static_cast<uint32_t>((val & 0x0000FFFF0000FFFF) * 42949672960001 >>
+                               32);
+}
+
+} // namespace neujson::internal
+
+#endif // NEUJSON_NEUJSON_INTERNAL_SWAR_H_
@@ -14,8 +14,7 @@ namespace neujson {
 namespace required {
 
 template <typename Stream>
-concept StreamCharTypeIsChar =
-    requires { std::same_as<typename Stream::char_type, char>; };
+concept StreamCharTypeIsChar = std::same_as<typename Stream::char_type, char>;
 
 } // namespace required
 
@@ -93,6 +92,11 @@ public:
     read();
   }
 
+  // bytes taken from the stream so far
+  [[nodiscard]] std::size_t tell() const {
+    return read_total_ + static_cast<std::size_t>(current_ - buffer_);
+  }
+
 private:
   void read() {
     if (current_ < buffer_last_) {
@@ -101,6 +105,7 @@ private:
       read_total_ += read_count_;
 
       // if no eof
+      read_count_ = buffer_size_;
       buffer_last_ = buffer_ + buffer_size_ - 1;
       current_ = buffer_;
 
@@ -127,6 +132,7 @@ private:
       read_total_ += read_count_;
 
       // if no eof
+      read_count_ = buffer_size_;
       buffer_last_ = buffer_ + buffer_size_ - 1;
       current_ = buffer_;
 
@@ -52,6 +52,25 @@
 #define NEUJSON_ASSERT(x) assert(x)
 #endif // NEUJSON_ASSERT
 
+/**
+ * @brief maximum nesting depth of arrays and objects accepted by the Reader,
+ * deeper input fails with error::DEPTH_EXCEEDED. The Reader keeps one byte per
+ * level on its own frame.
+ */
+#ifndef NEUJSON_PARSE_MAX_DEPTH
+#define NEUJSON_PARSE_MAX_DEPTH 1024
+#endif // NEUJSON_PARSE_MAX_DEPTH
+
+/**
+ * @brief 1 for programs whose Values never cross threads: the reference counts
+ * of shared strings and containers become plain integers, so copying and
+ * destroying Values takes no atomic instruction. Every translation unit of the
+ * program must see the same setting.
+ */
+#ifndef NEUJSON_SINGLE_THREADED_REFCOUNT
+#define NEUJSON_SINGLE_THREADED_REFCOUNT 0
+#endif // NEUJSON_SINGLE_THREADED_REFCOUNT
+
 /**
  * @brief const array length
  */
@@ -0,0 +1,86 @@
+#ifndef NEUJSON_NEUJSON_PADDED_READ_STREAM_H_
+#define NEUJSON_NEUJSON_PADDED_READ_STREAM_H_
+
+#include <cstring>
+
+#include <memory>
+#include <string_view>
+
+#include "neujson.h"
+#include "non_copyable.h"
+
+namespace neujson {
+
+/**
+ * @brief In-memory read stream with at least kPadding readable bytes after the
+ * end of the input, which lets the Reader use its SIMD kernels on it.
+ */
+class PaddedReadStream : public NonCopyable {
+public:
+  static constexpr std::size_t kPadding = 64;
+
+private:
+  std::unique_ptr<char[]> storage_;
+  const char *current_;
+  const char *end_;
+
+public:
+  /**
+   * @brief Copy json into an owned buffer followed by kPadding zero bytes.
+   * @param json
+   */
+  explicit PaddedReadStream(const std::string_view json)
+      : storage_(new char[json.size() + kPadding]), current_(storage_.get()),
+        end_(storage_.get() + json.size()) {
+    std::memcpy(storage_.get(), json.data(), json.size());
+    std::memset(storage_.get() + json.size(), 0, kPadding);
+  }
+
+  /**
+   * @brief Parse the caller's buffer in place, without copying.
+   * @param json start of the input
+   * @param length length of the input
+   * @param capacity readable bytes from json, at least length + kPadding
+   */
+  PaddedReadStream(const char *json, const std::size_t length,
+                   const std::size_t capacity)
+      : current_(json), end_(json + length) {
+    (void)capacity;
+    NEUJSON_ASSERT(capacity >= length + kPadding &&
+                   "buffer should be padded with kPadding bytes");
+  }
+
+  [[nodiscard]] bool hasNext() const { return current_ != end_; }
+
+  [[nodiscard]] char peek() const { return hasNext() ? *current_ : '\0'; }
+
+  char next() {
+    if (hasNext()) {
+      return *current_++;
+    }
+    return '\0';
+  }
+
+  void skip(const std::size_t n) {
+    if (static_cast<std::size_t>(end_ - current_) >= n) {
+      current_ += n;
+    }
+  }
+
+  void assertNext(const char ch) {
+    (void)ch;
+    NEUJSON_ASSERT(peek() == ch);
+    next();
+  }
+
+  [[nodiscard]] const char *getAddr() const { return current_; }
+  [[nodiscard]] const char *getEnd() const { return end_; }
+  void setAddr(const char *addr) {
+    NEUJSON_ASSERT(addr >= current_ && addr <= end_);
+    current_ = addr;
+  }
+};
+
+} // namespace neujson
+
+#endif // NEUJSON_NEUJSON_PADDED_READ_STREAM_H_
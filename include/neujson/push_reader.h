@@ -0,0 +1,429 @@
+#ifndef NEUJSON_NEUJSON_PUSH_READER_H_
+#define NEUJSON_NEUJSON_PUSH_READER_H_
+
+#include <cstddef>
+
+#include <string>
+#include <string_view>
+
+#include "exception.h"
+#include "internal/cursor.h"
+#include "internal/simd.h"
+#include "non_copyable.h"
+#include "reader.h"
+
+namespace neujson {
+
+/**
+ * @brief Resumable parser fed with the input in chunks of any size, as they
+ * arrive. It keeps its place between calls and drives the handler exactly
+ * like Reader::Parse() would over the chunks put together: same events, same
+ * flags, same error codes. Only a string, number or literal cut by the end of
+ * a chunk is copied, everything else is parsed straight from the chunk.
+ *
+ * Parse() returns error::NEED_MORE_INPUT while the document is incomplete,
+ * error::OK once the root value is complete, or the first error, which sticks.
+ * A root number or literal completes only at the byte after it, or at
+ * Finish(). Finish() marks the end of the input, returns the final result and
+ * readies the reader for the next document. Offsets count from the first byte
+ * of the first chunk.
+ */
+class PushReader : NonCopyable {
+  enum State : char {
+    kValue,         // a value, at the root, after ':' or after ',' in arrays
+    kValueOrClose,  // right after '['
+    kKey,           // after ',' in objects
+    kKeyOrClose,    // right after '{'
+    kColon,         // after a key
+    kCommaOrClose,  // after a value inside a container
+    kRootDone,      // after the root value, only whitespace may follow
+    kString,        // inside a string cut by the end of a chunk
+    kScalar,        // inside a number or literal cut by the end of a chunk
+  };
+
+  State state_ = kValue;
+  // '[' or '{' for every open container, innermost last
+  char stack_[NEUJSON_PARSE_MAX_DEPTH] = {};
+  std::size_t depth_ = 0;
+  // the part of a cut string or scalar seen so far
+  std::string token_;
+  // the cut string is a key
+  bool token_is_key_ = false;
+  // the cut string ends with a backslash escaping the next byte
+  bool escaped_ = false;
+  error::ParseError error_ = error::OK;
+  // where the reader stopped, and the bytes fed so far
+  std::size_t offset_ = 0;
+  std::size_t consumed_ = 0;
+  // scratch space for strings with escapes
+  std::string buffer_;
+
+public:
+  template <unsigned Flags = ParseFlags::kDefault,
+            required::handler::HasAllRequiredFunctions Handler>
+  [[nodiscard]] ParseResult Parse(std::string_view chunk, Handler &handler);
+
+  template <unsigned Flags = ParseFlags::kDefault,
+            required::handler::HasAllRequiredFunctions Handler>
+  [[nodiscard]] ParseResult Finish(Handler &handler);
+
+private:
+  template <unsigned Flags, required::handler::HasAllRequiredFunctions Handler>
+  [[nodiscard]] error::ParseError ResumeToken(const char *&p, const char *end,
+                                              Handler &handler);
+
+  template <unsigned Flags, required::handler::HasAllRequiredFunctions Handler>
+  [[nodiscard]] error::ParseError ParseChunk(const char *&p, const char *end,
+                                             Handler &handler);
+
+  template <unsigned Flags, required::handler::HasAllRequiredFunctions Handler>
+  [[nodiscard]] error::ParseError ParseToken(const char *&p,
+                                             const char *token_end,
+                                             const char *end, bool is_string,
+                                             Handler &handler);
+
+  // the root value is complete and nothing after it is to be parsed
+  template <unsigned Flags> [[nodiscard]] bool Done() const;
+
+  void ValueDone();
+  void Reset();
+
+  static bool IsDelimiter(char ch);
+  static const char *FindScalarEnd(const char *p, const char *end);
+  static const char *FindStringEnd(const char *p, const char *end,
+                                   bool &escaped);
+};
+
+template <unsigned Flags, required::handler::HasAllRequiredFunctions Handler>
+ParseResult PushReader::Parse(const std::string_view chunk, Handler &handler) {
+  if (error_ == error::OK && !Done<Flags>()) {
+    const char *p = chunk.data();
+    const char *end = chunk.data() + chunk.size();
+    if (state_ == kString || state_ == kScalar) {
+      error_ = ResumeToken<Flags>(p, end, handler);
+    }
+    if (error_ == error::OK && !Done<Flags>()) {
+      error_ = ParseChunk<Flags>(p, end, handler);
+      offset_ = consumed_ + static_cast<std::size_t>(p - chunk.data());
+    }
+  }
+  consumed_ += chunk.size();
+  if (error_ != error::OK) [[unlikely]] {
+    return {error_, offset_};
+  }
+  return {state_ == kRootDone ? error::OK : error::NEED_MORE_INPUT, offset_};
+}
+
+template <unsigned Flags, required::handler::HasAllRequiredFunctions Handler>
+ParseResult PushReader::Finish(Handler &handler) {
+  auto err = error_;
+  // the input ended here
+  auto offset = err == error::OK ? consumed_ : offset_;
+  if (err == error::OK) {
+    switch (state_) {
+    case kValue:
+    case kValueOrClose:
+      err = error::EXPECT_VALUE;
+      break;
+    case kKey:
+    case kKeyOrClose:
+      err = error::MISS_KEY;
+      break;
+    case kColon:
+      err = error::MISS_COLON;
+      break;
+    case kCommaOrClose:
+      err = stack_[depth_ - 1] == '[' ? error::MISS_COMMA_OR_SQUARE_BRACKET
+                                      : error::MISS_COMMA_OR_CURLY_BRACKET;
+      break;
+    case kRootDone:
+      offset = offset_;
+      break;
+    case kString:
+    case kScalar: {
+      // the token ends with the input, as it would in one piece
+      const char *p = token_.data();
+      err = ParseToken<Flags>(p, token_.data() + token_.size(),
+                              token_.data() + token_.size(), state_ == kString,
+                              handler);
+      offset = consumed_ - token_.size() +
+               static_cast<std::size_t>(p - token_.data());
+      if (err == error::OK) {
+        err = state_ == kRootDone ? error::OK
+                                  : (stack_[depth_ - 1] == '['
+                                         ? error::MISS_COMMA_OR_SQUARE_BRACKET
+                                         : error::MISS_COMMA_OR_CURLY_BRACKET);
+      }
+      break;
+    }
+    }
+  }
+  Reset();
+  return {err, offset};
+}
+
+template <unsigned Flags> bool PushReader::Done() const {
+  if constexpr ((Flags & ParseFlags::kStopWhenDone) != 0) {
+    return state_ == kRootDone;
+  } else {
+    return false;
+  }
+}
+
+inline void PushReader::ValueDone() {
+  state_ = depth_ == 0 ? kRootDone : kCommaOrClose;
+}
+
+inline void PushReader::Reset() {
+  state_ = kValue;
+  depth_ = 0;
+  token_.clear();
+  escaped_ = false;
+  error_ = error::OK;
+  offset_ = 0;
+  consumed_ = 0;
+}
+
+inline bool PushReader::IsDelimiter(const char ch) {
+  switch (ch) {
+  case ' ':
+  case '\n':
+  case '\r':
+  case '\t':
+  case ',':
+  case ':':
+  case '[':
+  case ']':
+  case '{':
+  case '}':
+  case '"':
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief The end of a number or literal: the first whitespace, structural
+ * character or quote, which the Reader would not take as part of it either.
+ * @return the delimiter, or end if the token may go on in the next chunk
+ */
+inline const char *PushReader::FindScalarEnd(const char *p,
+                                             const char *end) {
+  while (p != end && !IsDelimiter(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+/**
+ * @brief The closing quote of a string body.
+ * @param escaped in: the byte at p is escaped, out: the byte after end is
+ * @return the quote, or end if the string goes on in the next chunk
+ */
+inline const char *PushReader::FindStringEnd(const char *p, const char *end,
+                                             bool &escaped) {
+  if (escaped && p != end) {
+    ++p;
+    escaped = false;
+  }
+  while (p != end) {
+    p = internal::ScanString(p, end);
+    if (p == end || *p == '"') {
+      return p;
+    }
+    // a backslash skips the byte after it, control characters are left for
+    // the Reader to reject once the string is complete
+    if (*p == '\\' && ++p == end) {
+      escaped = true;
+      return end;
+    }
+    ++p;
+  }
+  return end;
+}
+
+#define TRY(_expr)                                                             \
+  if (const auto err_ = (_expr); err_ != error::OK) [[unlikely]]               \
+  return err_
+
+#define CALL(_expr)                                                            \
+  if (!(_expr)) [[unlikely]]                                                   \
+  return error::USER_STOPPED
+
+/**
+ * @brief Read a complete string or scalar with the Reader's own functions.
+ * @param p in: first byte of the token, out: where the Reader stopped
+ * @param token_end the delimiter after a scalar, or the closing quote
+ * @param end end of the readable bytes, which the Reader stops before
+ * @param is_string
+ * @param handler
+ * @return
+ */
+template <unsigned Flags, required::handler::HasAllRequiredFunctions Handler>
+error::ParseError PushReader::ParseToken(const char *&p,
+                                         const char *token_end,
+                                         const char *end,
+                                         const bool is_string,
+                                         Handler &handler) {
+  internal::Cursor cursor(p, end);
+  const auto err =
+      is_string
+          ? Reader::ParseString<Flags>(cursor, handler, buffer_, token_is_key_)
+          : Reader::ParseScalar<Flags>(cursor, handler, buffer_);
+  p = cursor.getAddr();
+  TRY(err);
+  if (is_string) {
+    if (token_is_key_) {
+      state_ = kColon;
+    } else {
+      ValueDone();
+    }
+    return error::OK;
+  }
+  if (p != token_end) {
+    // stopped short of the delimiter, at a byte which can not follow a value
+    if (depth_ == 0) {
+      if constexpr ((Flags & ParseFlags::kStopWhenDone) == 0) {
+        return error::ROOT_NOT_SINGULAR;
+      }
+    } else {
+      return stack_[depth_ - 1] == '[' ? error::MISS_COMMA_OR_SQUARE_BRACKET
+                                       : error::MISS_COMMA_OR_CURLY_BRACKET;
+    }
+  }
+  ValueDone();
+  return error::OK;
+}
+
+/**
+ * @brief Finish the token cut by the previous chunk. The token is read from
+ * its copy, so the offset is set here, for errors and for a root value the
+ * parse stops after.
+ * @param p in: start of the chunk, out: where to go on in it
+ * @param end
+ * @param handler
+ * @return
+ */
+template <unsigned Flags, required::handler::HasAllRequiredFunctions Handler>
+error::ParseError PushReader::ResumeToken(const char *&p, const char *end,
+                                          Handler &handler) {
+  const bool is_string = state_ == kString;
+  const char *token_end =
+      is_string ? FindStringEnd(p, end, escaped_) : FindScalarEnd(p, end);
+  if (token_end == end) {
+    token_.append(p, end);
+    p = end;
+    return error::OK;
+  }
+  const std::size_t token_offset = consumed_ - token_.size();
+  // up to the closing quote, or the delimiter the Reader stops a scalar at
+  token_.append(p, token_end + 1);
+  const char *stop = token_.data();
+  const auto err =
+      ParseToken<Flags>(stop, token_.data() + token_.size() - 1,
+                        token_.data() + token_.size(), is_string, handler);
+  offset_ = token_offset + static_cast<std::size_t>(stop - token_.data());
+  token_.clear();
+  p = is_string ? token_end + 1 : token_end;
+  return err;
+}
+
+template <unsigned Flags, required::handler::HasAllRequiredFunctions Handler>
+error::ParseError PushReader::ParseChunk(const char *&p, const char *end,
+                                         Handler &handler) {
+  // errors leave p at the byte at fault
+  while (!Done<Flags>()) {
+    p = internal::SkipWhitespace(p, end);
+    if (p == end) {
+      return error::OK;
+    }
+    const char ch = *p;
+    switch (state_) {
+    case kRootDone:
+      return error::ROOT_NOT_SINGULAR;
+    case kColon:
+      if (ch != ':') {
+        return error::MISS_COLON;
+      }
+      ++p;
+      state_ = kValue;
+      continue;
+    case kCommaOrClose: {
+      const bool in_array = stack_[depth_ - 1] == '[';
+      if (ch == ',') {
+        ++p;
+        state_ = in_array ? kValue : kKey;
+        continue;
+      }
+      if (ch != (in_array ? ']' : '}')) {
+        return in_array ? error::MISS_COMMA_OR_SQUARE_BRACKET
+                        : error::MISS_COMMA_OR_CURLY_BRACKET;
+      }
+      ++p;
+      depth_--;
+      CALL(in_array ? handler.EndArray() : handler.EndObject());
+      ValueDone();
+      continue;
+    }
+    case kKey:
+    case kKeyOrClose:
+      if (state_ == kKeyOrClose && ch == '}') {
+        ++p;
+        depth_--;
+        CALL(handler.EndObject());
+        ValueDone();
+        continue;
+      }
+      if (ch != '"') {
+        return error::MISS_KEY;
+      }
+      token_is_key_ = true;
+      break;
+    case kValueOrClose:
+      if (ch == ']') {
+        ++p;
+        depth_--;
+        CALL(handler.EndArray());
+        ValueDone();
+        continue;
+      }
+      [[fallthrough]];
+    default:
+      if (ch == '[' || ch == '{') {
+        if (depth_ == NEUJSON_PARSE_MAX_DEPTH) [[unlikely]] {
+          return error::DEPTH_EXCEEDED;
+        }
+        const bool is_array = ch == '[';
+        CALL(is_array ? handler.StartArray() : handler.StartObject());
+        ++p;
+        stack_[depth_++] = ch;
+        state_ = is_array ? kValueOrClose : kKeyOrClose;
+        continue;
+      }
+      token_is_key_ = false;
+      break;
+    }
+
+    // a string or scalar starts at p, a delimiter there is a scalar for the
+    // Reader to reject
+    const bool is_string = ch == '"';
+    const char *token_end = is_string ? FindStringEnd(p + 1, end, escaped_)
+                                      : FindScalarEnd(p, end);
+    if (token_end == end) {
+      token_.assign(p, end);
+      state_ = is_string ? kString : kScalar;
+      p = end;
+      return error::OK;
+    }
+    TRY(ParseToken<Flags>(p, token_end, end, is_string, handler));
+  }
+  return error::OK;
+}
+
+#undef CALL
+#undef TRY
+
+} // namespace neujson
+
+#endif // NEUJSON_NEUJSON_PUSH_READER_H_
@@ -6,34 +6,22 @@
 #define NEUJSON_NEUJSON_READER_H_
 
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 
-#include <exception>
+#include <limits>
+#include <string>
 
 #include "exception.h"
 #include "internal/cllzl.h"
+#include "internal/cursor.h"
+#include "internal/simd.h"
+#include "internal/strtod.h"
+#include "internal/swar.h"
 #include "non_copyable.h"
 #include "value.h"
 
-#if defined(NEUJSON_SSE42)
-#include <nmmintrin.h>
-#elif defined(NEUJSON_SSE2)
-#include <emmintrin.h>
-#elif defined(NEUJSON_NEON)
-#include <arm_neon.h>
-#endif
-
-#if defined(NEUJSON_SSE42)
-#undef NEUJSON_SSE42
-#define NEUJSON_SSE42_OFF
-#elif defined(NEUJSON_SSE2)
-#undef NEUJSON_SSE2
-#define NEUJSON_SSE2_OFF
-#elif defined(NEUJSON_NEON)
-#undef NEUJSON_NEON
-#define NEUJSON_NEON_OFF
-#endif
-
 namespace neujson {
 
 namespace required::read_stream {
@@ -54,16 +42,29 @@ concept HasNext = requires(ReadStream rs) {
   { rs.next() } -> std::same_as<char>;
 };
 
-#if defined(NEUJSON_SSE42) || defined(NEUJSON_SSE2) || defined(NEUJSON_NEON)
 template <typename ReadStream>
-concept HasSkip = requires(ReadStream rs, std::size_t n) {
-  { rs.skip(n) } -> std::same_as<void>;
+concept HasAssertNext = requires(ReadStream rs, char ch) {
+  { rs.assertNext(ch) } -> std::same_as<void>;
 };
-#endif
 
 template <typename ReadStream>
-concept HasAssertNext = requires(ReadStream rs, char ch) {
-  { rs.assertNext(ch) } -> std::same_as<void>;
+concept HasGetAddr = requires(ReadStream rs) {
+  { rs.getAddr() } -> std::convertible_to<const char *>;
+};
+
+template <typename ReadStream>
+concept HasGetEnd = requires(ReadStream rs) {
+  { rs.getEnd() } -> std::convertible_to<const char *>;
+};
+
+template <typename ReadStream>
+concept HasSetAddr = requires(ReadStream rs, const char *addr) {
+  { rs.setAddr(addr) } -> std::same_as<void>;
+};
+
+template <typename ReadStream>
+concept HasTell = requires(ReadStream rs) {
+  { rs.tell() } -> std::same_as<std::size_t>;
 };
 
 } // namespace details
@@ -71,590 +72,752 @@ concept HasAssertNext = requires(ReadStream rs, char ch) {
 template <typename T>
 concept HasAllRequiredFunctions =
     details::HasHasNext<T> && details::HasPeek<T> && details::HasNext<T> &&
-#if defined(NEUJSON_SSE42) || defined(NEUJSON_SSE2) || defined(NEUJSON_NEON)
-    details::HasSkip<T> &&
-#endif
     details::HasAssertNext<T>;
 
+/**
+ * @brief Streams whose whole input is one in-memory buffer. The Reader parses
+ * them straight off [getAddr(), getEnd()) and hands the final position back
+ * through setAddr().
+ */
+template <typename T>
+concept IsContiguous =
+    HasAllRequiredFunctions<T> && details::HasGetAddr<T> &&
+    details::HasGetEnd<T> && details::HasSetAddr<T>;
+
+/**
+ * @brief Contiguous streams which guarantee at least 64 readable bytes past
+ * getEnd(), so SIMD kernels may load whole blocks up to the end of the input.
+ */
+template <typename T>
+concept IsPadded = IsContiguous<T> && requires {
+  requires T::kPadding >= 64;
+};
+
+/**
+ * @brief Contiguous streams over a writable buffer, into which the Reader
+ * unescapes strings in place.
+ */
+template <typename T>
+concept IsInsitu = IsContiguous<T> && requires(T rs) {
+  { rs.getMutableAddr() } -> std::same_as<char *>;
+};
+
 } // namespace required::read_stream
 
+/**
+ * @brief Compile-time switches of the Reader, combined with '|' and passed as
+ * the Flags template argument of Reader::Parse() and the Document parse
+ * functions. Features left out are compiled out of the parse as well.
+ */
+struct ParseFlags {
+  enum : unsigned {
+    kNone = 0,
+    // correctly rounded doubles, otherwise they may be off by a few ulp
+    kFullPrecision = 1U << 0,
+    // accept the NaN and Infinity literals
+    kNanAndInf = 1U << 1,
+    // stop right after the root value, whatever follows it
+    kStopWhenDone = 1U << 2,
+    // reject strings which are not well-formed UTF-8
+    kValidateUtf8 = 1U << 3,
+    // let the repeated keys of a Document share their storage, the readers
+    // themselves ignore it
+    kInternKeys = 1U << 4,
+    kDefault = kFullPrecision | kNanAndInf,
+  };
+};
+
 class Reader : NonCopyable {
 public:
-  template <required::read_stream::HasAllRequiredFunctions ReadStream,
+  /**
+   * @brief Parse one JSON text from the stream into the handler.
+   * @return the error code and the offset the reader stopped at, which is
+   * only known for contiguous streams and streams with tell(), 0 otherwise
+   */
+  template <unsigned Flags = ParseFlags::kDefault,
+            required::read_stream::HasAllRequiredFunctions ReadStream,
+            required::handler::HasAllRequiredFunctions Handler>
+  [[nodiscard]] static ParseResult Parse(ReadStream &rs, Handler &handler);
+
+  /**
+   * @brief Parse with buffer as the scratch space for strings with escapes,
+   * so that callers parsing one text after another, such as Document, keep
+   * its capacity rather than allocating it anew every time.
+   */
+  template <unsigned Flags = ParseFlags::kDefault,
+            required::read_stream::HasAllRequiredFunctions ReadStream,
             required::handler::HasAllRequiredFunctions Handler>
-  static error::ParseError Parse(ReadStream &rs, Handler &handler);
+  [[nodiscard]] static ParseResult Parse(ReadStream &rs, Handler &handler,
+                                         std::string &buffer);
 
 private:
-  template <required::read_stream::HasAllRequiredFunctions ReadStream>
-  static unsigned ParseHex4(ReadStream &rs);
+  // the push and two-stage parsers read their tokens with these functions
+  friend class PushReader;
+  friend class StructuralReader;
+
+  // every step reports failure through its return value, so rejecting bad
+  // input costs no more than accepting good input, exceptions or not
+  template <unsigned Flags,
+            required::read_stream::HasAllRequiredFunctions ReadStream,
+            required::handler::HasAllRequiredFunctions Handler>
+  [[nodiscard]] static error::ParseError
+  ParseRoot(ReadStream &rs, Handler &handler, std::string &buffer);
 
-#if defined(NEUJSON_SSE42)
-  template <required::read_stream::HasAllRequiredFunctions ReadStream>
-  static void ParseWhitespaceSSE42(ReadStream &rs);
-#elif defined(NEUJSON_SSE2)
-  template <required::read_stream::HasAllRequiredFunctions ReadStream>
-  static void ParseWhitespaceSSE2(ReadStream &rs);
-#elif defined(NEUJSON_NEON)
-  template <required::read_stream::HasAllRequiredFunctions ReadStream>
-  static void ParseWhitespaceNEON(ReadStream &rs);
-#else
   template <required::read_stream::HasAllRequiredFunctions ReadStream>
-  static void ParseWhitespaceBasic(ReadStream &rs);
-#endif
+  [[nodiscard]] static error::ParseError ParseHex4(ReadStream &rs,
+                                                   unsigned *u);
 
   template <required::read_stream::HasAllRequiredFunctions ReadStream>
   static void ParseWhitespace(ReadStream &rs);
 
+  template <required::read_stream::IsContiguous ReadStream>
+  static const char *ScanString(const ReadStream &rs);
+
   template <required::read_stream::HasAllRequiredFunctions ReadStream,
             required::handler::HasAllRequiredFunctions Handler>
-  static void ParseLiteral(ReadStream &rs, Handler &handler,
-                           const char *literal, Type type);
+  [[nodiscard]] static error::ParseError
+  ParseLiteral(ReadStream &rs, Handler &handler, const char *literal,
+               Type type);
 
-  template <required::read_stream::HasAllRequiredFunctions ReadStream,
+  template <unsigned Flags,
+            required::read_stream::HasAllRequiredFunctions ReadStream,
             required::handler::HasAllRequiredFunctions Handler>
-  static void ParseNumber(ReadStream &rs, Handler &handler);
+  [[nodiscard]] static error::ParseError
+  ParseNumber(ReadStream &rs, Handler &handler, std::string &buffer);
 
-  template <required::read_stream::HasAllRequiredFunctions ReadStream,
+  template <unsigned Flags,
+            required::read_stream::HasAllRequiredFunctions ReadStream,
             required::handler::HasAllRequiredFunctions Handler>
-  static void ParseString(ReadStream &rs, Handler &handler, bool is_key);
+  [[nodiscard]] static error::ParseError ParseString(ReadStream &rs,
+                                                     Handler &handler,
+                                                     std::string &buffer,
+                                                     bool is_key);
+
+  template <unsigned Flags,
+            required::read_stream::HasAllRequiredFunctions ReadStream,
+            required::handler::HasAllRequiredFunctions Handler,
+            typename Buffer>
+  [[nodiscard]] static error::ParseError ParseStringTo(ReadStream &rs,
+                                                       Handler &handler,
+                                                       Buffer &buffer,
+                                                       bool is_key);
+
+  template <unsigned Flags,
+            required::read_stream::HasAllRequiredFunctions ReadStream,
+            typename Buffer>
+  [[nodiscard]] static error::ParseError ParseEscape(ReadStream &rs,
+                                                     Buffer &buffer);
 
-  template <required::read_stream::HasAllRequiredFunctions ReadStream,
+  template <required::read_stream::HasAllRequiredFunctions ReadStream>
+  [[nodiscard]] static error::ParseError ParseUtf8Sequence(ReadStream &rs,
+                                                           std::string &buffer);
+
+  template <unsigned Flags,
+            required::read_stream::HasAllRequiredFunctions ReadStream,
             required::handler::HasAllRequiredFunctions Handler>
-  static void ParseArray(ReadStream &rs, Handler &handler);
+  [[nodiscard]] static error::ParseError
+  ParseKey(ReadStream &rs, Handler &handler, std::string &buffer);
 
-  template <required::read_stream::HasAllRequiredFunctions ReadStream,
+  template <unsigned Flags,
+            required::read_stream::HasAllRequiredFunctions ReadStream,
             required::handler::HasAllRequiredFunctions Handler>
-  static void ParseObject(ReadStream &rs, Handler &handler);
+  [[nodiscard]] static error::ParseError
+  ParseScalar(ReadStream &rs, Handler &handler, std::string &buffer);
 
-  template <required::read_stream::HasAllRequiredFunctions ReadStream,
+  template <unsigned Flags,
+            required::read_stream::HasAllRequiredFunctions ReadStream,
             required::handler::HasAllRequiredFunctions Handler>
-  static void ParseValue(ReadStream &rs, Handler &handler);
+  [[nodiscard]] static error::ParseError
+  ParseValue(ReadStream &rs, Handler &handler, std::string &buffer);
 
   static bool IsDigit(const char ch) { return ch >= '0' && ch <= '9'; }
   static bool IsDigit1To9(const char ch) { return ch >= '1' && ch <= '9'; }
-  static void EncodeUtf8(std::string &buffer, unsigned int u);
+  template <typename Buffer>
+  static void EncodeUtf8(Buffer &buffer, unsigned int u);
 };
 
-template <required::read_stream::HasAllRequiredFunctions ReadStream,
+template <unsigned Flags,
+          required::read_stream::HasAllRequiredFunctions ReadStream,
           required::handler::HasAllRequiredFunctions Handler>
-error::ParseError Reader::Parse(ReadStream &rs, Handler &handler) {
-  try {
-    ParseWhitespace(rs);
-    ParseValue(rs, handler);
+ParseResult Reader::Parse(ReadStream &rs, Handler &handler) {
+  std::string buffer;
+  return Parse<Flags>(rs, handler, buffer);
+}
+
+template <unsigned Flags,
+          required::read_stream::HasAllRequiredFunctions ReadStream,
+          required::handler::HasAllRequiredFunctions Handler>
+ParseResult Reader::Parse(ReadStream &rs, Handler &handler,
+                          std::string &buffer) {
+  if constexpr (required::read_stream::IsInsitu<ReadStream>) {
+    internal::InsituCursor cursor(rs.getMutableAddr(), rs.getEnd());
+    const auto err = ParseRoot<Flags>(cursor, handler, buffer);
+    const auto offset = cursor.getAddr() - rs.getAddr();
+    rs.setAddr(cursor.getAddr());
+    return {err, static_cast<std::size_t>(offset)};
+  } else if constexpr (required::read_stream::IsPadded<ReadStream>) {
+    internal::PaddedCursor cursor(rs.getAddr(), rs.getEnd());
+    const auto err = ParseRoot<Flags>(cursor, handler, buffer);
+    const auto offset = cursor.getAddr() - rs.getAddr();
+    rs.setAddr(cursor.getAddr());
+    return {err, static_cast<std::size_t>(offset)};
+  } else if constexpr (required::read_stream::IsContiguous<ReadStream>) {
+    internal::Cursor cursor(rs.getAddr(), rs.getEnd());
+    const auto err = ParseRoot<Flags>(cursor, handler, buffer);
+    const auto offset = cursor.getAddr() - rs.getAddr();
+    rs.setAddr(cursor.getAddr());
+    return {err, static_cast<std::size_t>(offset)};
+  } else if constexpr (required::read_stream::details::HasTell<ReadStream>) {
+    const std::size_t start = rs.tell();
+    const auto err = ParseRoot<Flags>(rs, handler, buffer);
+    return {err, rs.tell() - start};
+  } else {
+    return {ParseRoot<Flags>(rs, handler, buffer), 0};
+  }
+}
+
+template <unsigned Flags,
+          required::read_stream::HasAllRequiredFunctions ReadStream,
+          required::handler::HasAllRequiredFunctions Handler>
+error::ParseError Reader::ParseRoot(ReadStream &rs, Handler &handler,
+                                    std::string &buffer) {
+  buffer.clear();
+  ParseWhitespace(rs);
+  if (const auto err = ParseValue<Flags>(rs, handler, buffer);
+      err != error::OK) [[unlikely]] {
+    return err;
+  }
+  if constexpr ((Flags & ParseFlags::kStopWhenDone) == 0) {
     ParseWhitespace(rs);
     if (rs.hasNext()) {
-      throw Exception(error::ROOT_NOT_SINGULAR);
+      return error::ROOT_NOT_SINGULAR;
     }
-    return error::OK;
-  } catch (Exception &e) {
-    return e.err();
   }
+  return error::OK;
 }
 
 template <required::read_stream::HasAllRequiredFunctions ReadStream>
-unsigned Reader::ParseHex4(ReadStream &rs) {
-  unsigned int u = 0;
+error::ParseError Reader::ParseHex4(ReadStream &rs, unsigned *u) {
+  *u = 0;
   for (int i = 0; i < 4; i++) {
-    u <<= 4;
+    *u <<= 4;
     if (const char ch = rs.next(); ch >= '0' && ch <= '9') {
-      u |= static_cast<unsigned int>(ch - '0');
+      *u |= static_cast<unsigned int>(ch - '0');
     } else if (ch >= 'a' && ch <= 'f') {
-      u |= static_cast<unsigned int>(ch - 'a' + 10);
+      *u |= static_cast<unsigned int>(ch - 'a' + 10);
     } else if (ch >= 'A' && ch <= 'F') {
-      u |= static_cast<unsigned int>(ch - 'A' + 10);
+      *u |= static_cast<unsigned int>(ch - 'A' + 10);
     } else {
-      throw Exception(error::BAD_UNICODE_HEX);
+      return error::BAD_UNICODE_HEX;
     }
   }
-  return u;
+  return error::OK;
 }
 
-#if defined(NEUJSON_SSE42)
 /**
- * @brief Skip whitespace with SSE 4.2 pcmpistrm instruction, testing 16 8-byte
- * characters at once.
+ * @brief Skip whitespace. Contiguous input goes through the SIMD kernel picked
+ * for this CPU once the run is longer than a single separator; padded input
+ * lets the kernel run whole blocks up to the end of the padding.
  * @tparam ReadStream
  * @param rs
  */
 template <required::read_stream::HasAllRequiredFunctions ReadStream>
-void Reader::ParseWhitespaceSSE42(ReadStream &rs) {
-  char ch = rs.peek();
-  if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
-    rs.next();
-  } else {
-    return;
-  }
-
-  // 16-byte align to the next boundary
-  const char *p = rs.getAddr();
-  const char *nextAligned = reinterpret_cast<const char *>(
-      (reinterpret_cast<size_t>(p) + 15) & static_cast<size_t>(~15));
-  while (p != nextAligned) {
-    if (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t') {
-      ++p;
-      rs.next();
-    } else {
-      return;
-    }
-  }
-
-  // The rest of string using SIMD
-  static const char whitespace[16] = " \n\r\t";
-  const __m128i w =
-      _mm_loadu_si128(reinterpret_cast<const __m128i *>(&whitespace[0]));
-
-  for (;; p += 16, rs.skip(16)) {
-    const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
-    const int r =
-        _mm_cmpistri(w, s,
-                     _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY |
-                         _SIDD_LEAST_SIGNIFICANT | _SIDD_NEGATIVE_POLARITY);
-    // some characters are non-whitespace
-    if (r != 16) {
-      rs.skip(r);
-      return;
+void Reader::ParseWhitespace(ReadStream &rs) {
+  if constexpr (required::read_stream::IsContiguous<ReadStream>) {
+    const char *p = rs.getAddr();
+    const char *end = rs.getEnd();
+    if (p != end && internal::IsWhitespace(*p) && ++p != end &&
+        internal::IsWhitespace(*p)) {
+      if constexpr (required::read_stream::IsPadded<ReadStream>) {
+        p = internal::SkipWhitespace(p, end + ReadStream::kPadding);
+        p = p < end ? p : end;
+      } else {
+        p = internal::SkipWhitespace(p, end);
+      }
     }
-  }
-}
-#elif defined(NEUJSON_SSE2)
-/**
- * @brief Skip whitespace with SSE2 instructions, testing 16 8-byte characters
- * at once.
- * @tparam ReadStream
- * @param rs
- */
-template <required::read_stream::HasAllRequiredFunctions ReadStream>
-void Reader::ParseWhitespaceSSE2(ReadStream &rs) {
-  // Fast return for single non-whitespace
-  char ch = rs.peek();
-  if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
-    rs.next();
+    rs.setAddr(p);
   } else {
-    return;
-  }
-
-  // 16-byte align to the next boundary
-  const char *p = rs.getAddr();
-  const char *nextAligned = reinterpret_cast<const char *>(
-      (reinterpret_cast<size_t>(p) + 15) & static_cast<size_t>(~15));
-  while (p != nextAligned) {
-    if (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t') {
-      ++p;
-      rs.next();
-    } else {
-      return;
-    }
-  }
-
-  // The rest of string
-#define C16(c) {c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c}
-  static const char whitespaces[4][16] = {C16(' '), C16('\n'), C16('\r'),
-                                          C16('\t')};
-#undef C16
-
-  const __m128i w0 =
-      _mm_loadu_si128(reinterpret_cast<const __m128i *>(&whitespaces[0][0]));
-  const __m128i w1 =
-      _mm_loadu_si128(reinterpret_cast<const __m128i *>(&whitespaces[1][0]));
-  const __m128i w2 =
-      _mm_loadu_si128(reinterpret_cast<const __m128i *>(&whitespaces[2][0]));
-  const __m128i w3 =
-      _mm_loadu_si128(reinterpret_cast<const __m128i *>(&whitespaces[3][0]));
-
-  for (;; p += 16, rs.skip(16)) {
-    const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
-    __m128i x = _mm_cmpeq_epi8(s, w0);
-    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, w1));
-    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, w2));
-    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, w3));
-    auto r = static_cast<unsigned short>(~_mm_movemask_epi8(x));
-    if (r != 0) { // some characters may be non-whitespace
-#ifdef _MSC_VER // Find the index of first non-whitespace
-      unsigned long offset;
-      _BitScanForward(&offset, r);
-      rs.skip(offset);
-      return;
-#else
-      rs.skip(__builtin_ffs(r) - 1);
-      return;
-#endif
+    while (rs.hasNext()) {
+      if (const char ch = rs.peek();
+          ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+        rs.next();
+      } else {
+        break;
+      }
     }
   }
 }
-#elif defined(NEUJSON_NEON)
+
 /**
- * @brief Skip whitespace with ARM Neon instructions, testing 16 8-byte
- * characters at once.
+ * @brief Find the end of the verbatim run of a string body starting at the
+ * stream position, see internal::Kernels::scan_string.
  * @tparam ReadStream
  * @param rs
+ * @return the first quote, backslash or control character, or the input end
  */
-template <required::read_stream::HasAllRequiredFunctions ReadStream>
-void Reader::ParseWhitespaceNEON(ReadStream &rs) {
-  char ch = rs.peek();
-  if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
-    rs.next();
+template <required::read_stream::IsContiguous ReadStream>
+const char *Reader::ScanString(const ReadStream &rs) {
+  const char *end = rs.getEnd();
+  if constexpr (required::read_stream::IsPadded<ReadStream>) {
+    const char *p =
+        internal::ScanString(rs.getAddr(), end + ReadStream::kPadding);
+    return p < end ? p : end;
   } else {
-    return;
-  }
-
-  // 16-byte align to the next boundary
-  const char *p = rs.getAddr();
-  const char *nextAligned = reinterpret_cast<const char *>(
-      (reinterpret_cast<size_t>(p) + 15) & static_cast<size_t>(~15));
-  while (p != nextAligned) {
-    if (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t') {
-      ++p;
-      rs.next();
-    } else {
-      return;
-    }
-  }
-
-  const uint8x16_t w0 = vmovq_n_u8(' ');
-  const uint8x16_t w1 = vmovq_n_u8('\n');
-  const uint8x16_t w2 = vmovq_n_u8('\r');
-  const uint8x16_t w3 = vmovq_n_u8('\t');
-
-  for (;; p += 16, rs.skip(16)) {
-    const uint8x16_t s = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
-    uint8x16_t x = vceqq_u8(s, w0);
-    x = vorrq_u8(x, vceqq_u8(s, w1));
-    x = vorrq_u8(x, vceqq_u8(s, w2));
-    x = vorrq_u8(x, vceqq_u8(s, w3));
-
-    x = vmvnq_u8(x);                                            // Negate
-    x = vrev64q_u8(x);                                          // Rev in 64
-    uint64_t low = vgetq_lane_u64(vreinterpretq_u64_u8(x), 0);  // extract
-    uint64_t high = vgetq_lane_u64(vreinterpretq_u64_u8(x), 1); // extract
-
-    if (low == 0) {
-      if (high != 0) {
-        uint32_t lz = internal::clzll(high);
-        rs.skip(8 + (lz >> 3));
-        return;
-      }
-    } else {
-      uint32_t lz = internal::clzll(low);
-      rs.skip(lz >> 3);
-      return;
-    }
-  }
-}
-#else
-template <required::read_stream::HasAllRequiredFunctions ReadStream>
-void Reader::ParseWhitespaceBasic(ReadStream &rs) {
-  while (rs.hasNext()) {
-    if (const char ch = rs.peek();
-        ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
-      rs.next();
-    } else {
-      break;
-    }
+    return internal::ScanString(rs.getAddr(), end);
   }
 }
-#endif
 
-template <required::read_stream::HasAllRequiredFunctions ReadStream>
-void Reader::ParseWhitespace(ReadStream &rs) {
-#if defined(NEUJSON_SSE42)
-  return ParseWhitespaceSSE42(rs);
-#elif defined(NEUJSON_SSE2)
-  return ParseWhitespaceSSE2(rs);
-#elif defined(NEUJSON_NEON)
-  return ParseWhitespaceNEON(rs);
-#else
-  return ParseWhitespaceBasic(rs);
-#endif
-}
+#define TRY(_expr)                                                             \
+  if (const auto err_ = (_expr); err_ != error::OK) [[unlikely]]               \
+  return err_
 
 #define CALL(_expr)                                                            \
-  if (!(_expr))                                                                \
-  throw Exception(error::USER_STOPPED)
+  if (!(_expr)) [[unlikely]]                                                   \
+  return error::USER_STOPPED
 
 template <required::read_stream::HasAllRequiredFunctions ReadStream,
           required::handler::HasAllRequiredFunctions Handler>
-void Reader::ParseLiteral(ReadStream &rs, Handler &handler, const char *literal,
-                          const Type type) {
+error::ParseError Reader::ParseLiteral(ReadStream &rs, Handler &handler,
+                                       const char *literal, const Type type) {
   const char c = *literal;
 
-  rs.assertNext(*literal++);
-  for (; *literal != '\0'; literal++, rs.next()) {
-    if (*literal != rs.peek()) {
-      throw Exception(error::BAD_VALUE);
+  if constexpr (required::read_stream::IsContiguous<ReadStream>) {
+    const char *p = rs.getAddr();
+    const std::size_t len = std::strlen(literal);
+    if (static_cast<std::size_t>(rs.getEnd() - p) < len ||
+        std::memcmp(p, literal, len) != 0) [[unlikely]] {
+      // stop at the first byte which does not match, as streams do
+      const char *end = rs.getEnd();
+      while (p != end && *p == *literal) {
+        ++p;
+        ++literal;
+      }
+      rs.setAddr(p);
+      return error::BAD_VALUE;
+    }
+    rs.setAddr(p + len);
+  } else {
+    rs.assertNext(*literal++);
+    for (; *literal != '\0'; literal++, rs.next()) {
+      if (*literal != rs.peek()) {
+        return error::BAD_VALUE;
+      }
     }
   }
 
   switch (type) {
   case NEU_NULL:
     CALL(handler.Null());
-    return;
+    return error::OK;
   case NEU_BOOL:
     CALL(handler.Bool(c == 't'));
-    return;
+    return error::OK;
   case NEU_DOUBLE:
     CALL(handler.Double(
         internal::Double(c == 'N' ? std::numeric_limits<double>::quiet_NaN()
                                   : std::numeric_limits<double>::infinity())));
-    return;
+    return error::OK;
   default:
     NEUJSON_ASSERT(false && "bad type");
+    return error::BAD_VALUE;
   }
 }
 
-template <required::read_stream::HasAllRequiredFunctions ReadStream,
+template <unsigned Flags,
+          required::read_stream::HasAllRequiredFunctions ReadStream,
           required::handler::HasAllRequiredFunctions Handler>
-void Reader::ParseNumber(ReadStream &rs, Handler &handler) {
+error::ParseError Reader::ParseNumber(ReadStream &rs, Handler &handler,
+                                      std::string &buffer) {
   // parse 'NaN' (Not a Number) && 'Infinity'
-  if (rs.peek() == 'N') {
-    ParseLiteral(rs, handler, "NaN", NEU_DOUBLE);
-    return;
-  }
-  if (rs.peek() == 'I') {
-    ParseLiteral(rs, handler, "Infinity", NEU_DOUBLE);
-    return;
+  if constexpr ((Flags & ParseFlags::kNanAndInf) != 0) {
+    if (rs.peek() == 'N') {
+      return ParseLiteral(rs, handler, "NaN", NEU_DOUBLE);
+    }
+    if (rs.peek() == 'I') {
+      return ParseLiteral(rs, handler, "Infinity", NEU_DOUBLE);
+    }
   }
 
-  std::string buffer;
-
-  if (rs.peek() == '-') {
-    buffer.push_back(rs.next());
+  // the number text is only read again for unusual doubles: contiguous input
+  // keeps it in place, other streams record it in the scratch buffer
+  const char *start = nullptr;
+  if constexpr (required::read_stream::IsContiguous<ReadStream>) {
+    start = rs.getAddr();
+  } else {
+    buffer.clear();
   }
+  const auto take = [&rs, &buffer]() -> char {
+    const char ch = rs.next();
+    if constexpr (!required::read_stream::IsContiguous<ReadStream>) {
+      buffer.push_back(ch);
+    } else {
+      (void)buffer;
+    }
+    return ch;
+  };
+
+  // the integer part is accumulated while reading, at most 19 digits always
+  // fit in an uint64_t, more than that never fit in an int64_t
+  const bool minus = rs.peek() == '-';
+  if (minus) {
+    take();
+  }
+  uint64_t u64 = 0;
+  int digits = 0;
   if (rs.peek() == '0') {
-    buffer.push_back(rs.next());
+    take();
   } else {
     if (!IsDigit1To9(rs.peek())) {
-      throw Exception(error::BAD_VALUE);
+      return error::BAD_VALUE;
+    }
+    if constexpr (required::read_stream::IsContiguous<ReadStream>) {
+      const char *p = rs.getAddr();
+      while (rs.getEnd() - p >= 8) {
+        const uint64_t chunk = internal::LoadEightChars(p);
+        if (!internal::IsEightDigits(chunk)) {
+          break;
+        }
+        u64 = u64 * 100000000 + internal::ParseEightDigits(chunk);
+        p += 8;
+        digits += 8;
+      }
+      rs.setAddr(p);
+    }
+    for (; IsDigit(rs.peek()); digits++) {
+      u64 = u64 * 10 + static_cast<unsigned>(take() - '0');
+    }
+  }
+
+  if (rs.peek() != '.' && rs.peek() != 'e' && rs.peek() != 'E') {
+    constexpr auto kInt64Max =
+        static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+    constexpr auto kInt32Max =
+        static_cast<uint64_t>(std::numeric_limits<int32_t>::max());
+    if (digits > internal::kMaxSignificantDigits || u64 > kInt64Max + minus) {
+      return error::NUMBER_TOO_BIG;
+    }
+    // two's complement negation, exact for the minimum values as well
+    const uint64_t bits = minus ? 0 - u64 : u64;
+    if (u64 <= kInt32Max + minus) {
+      CALL(handler.Int32(static_cast<int32_t>(static_cast<int64_t>(bits))));
+    } else {
+      CALL(handler.Int64(static_cast<int64_t>(bits)));
     }
-    for (buffer.push_back(rs.next()); IsDigit(rs.peek());
-         buffer.push_back(rs.next()))
-      ;
+    return error::OK;
   }
 
-  auto expectType = NEU_NULL;
+  // doubles: the first 19 significant digits make the significand, further
+  // ones only move the decimal exponent
+  const auto text = [&]() -> std::string_view {
+    if constexpr (required::read_stream::IsContiguous<ReadStream>) {
+      return {start, static_cast<std::size_t>(rs.getAddr() - start)};
+    } else {
+      (void)start;
+      return buffer;
+    }
+  };
+  uint64_t significand = u64;
+  int64_t exp = 0;
+  bool truncated = false;
+  if (digits > internal::kMaxSignificantDigits) {
+    const std::string_view integer = text().substr(minus);
+    significand = 0;
+    for (int i = 0; i < internal::kMaxSignificantDigits; i++) {
+      significand = significand * 10 + static_cast<unsigned>(integer[i] - '0');
+    }
+    significand += integer[internal::kMaxSignificantDigits] >= '5';
+    exp = digits - internal::kMaxSignificantDigits;
+    digits = internal::kMaxSignificantDigits;
+    truncated = true;
+  }
 
   if (rs.peek() == '.') {
-    expectType = NEU_DOUBLE;
-    buffer.push_back(rs.next());
+    take();
     if (!IsDigit(rs.peek())) {
-      throw Exception(error::BAD_VALUE);
+      return error::BAD_VALUE;
+    }
+    if (significand == 0) {
+      // leading zeros are not significant
+      for (; rs.peek() == '0'; exp--) {
+        take();
+      }
+    }
+    if constexpr (required::read_stream::IsContiguous<ReadStream>) {
+      const char *p = rs.getAddr();
+      while (digits <= internal::kMaxSignificantDigits - 8 &&
+             rs.getEnd() - p >= 8) {
+        const uint64_t chunk = internal::LoadEightChars(p);
+        if (!internal::IsEightDigits(chunk)) {
+          break;
+        }
+        significand =
+            significand * 100000000 + internal::ParseEightDigits(chunk);
+        p += 8;
+        digits += 8;
+        exp -= 8;
+      }
+      rs.setAddr(p);
+    }
+    while (IsDigit(rs.peek())) {
+      const char ch = take();
+      if (digits < internal::kMaxSignificantDigits) {
+        significand = significand * 10 + static_cast<unsigned>(ch - '0');
+        digits++;
+        exp--;
+      } else if (!truncated) {
+        significand += ch >= '5';
+        truncated = true;
+      }
     }
-    for (buffer.push_back(rs.next()); IsDigit(rs.peek());
-         buffer.push_back(rs.next()))
-      ;
   }
 
   if (rs.peek() == 'e' || rs.peek() == 'E') {
-    expectType = NEU_DOUBLE;
-    buffer.push_back(rs.next());
+    take();
+    bool exp_minus = false;
     if (rs.peek() == '+' || rs.peek() == '-') {
-      buffer.push_back(rs.next());
+      exp_minus = take() == '-';
     }
     if (!IsDigit(rs.peek())) {
-      throw Exception(error::BAD_VALUE);
+      return error::BAD_VALUE;
+    }
+    int64_t e = 0;
+    while (IsDigit(rs.peek())) {
+      e = internal::AppendExponentDigit(e, take());
     }
-    for (buffer.push_back(rs.next()); IsDigit(rs.peek());
-         buffer.push_back(rs.next()))
-      ;
+    exp += exp_minus ? -e : e;
   }
 
-  if (buffer.empty()) {
-    throw Exception(error::BAD_VALUE);
+  double d;
+  if constexpr ((Flags & ParseFlags::kFullPrecision) != 0) {
+    d = internal::StrtodFullPrecision(significand, digits, exp, truncated,
+                                      text());
+  } else {
+    d = internal::StrtodNormalPrecision(significand, digits, exp);
   }
-
-  try {
-    std::size_t idx;
-    if (expectType == NEU_DOUBLE) {
-      double d;
-#if defined(__clang__) || defined(_MSC_VER)
-      d = std::stod(buffer, &idx);
-#elif defined(__GNUC__)
-      d = __gnu_cxx::__stoa(&std::strtod, "stod", buffer.data(), &idx);
-#else
-#error "complier no support"
-#endif
-      NEUJSON_ASSERT(buffer.size() == idx);
-      CALL(handler.Double(internal::Double(d)));
-    } else {
-      int64_t i64;
-#if defined(__clang__) || defined(_MSC_VER)
-      i64 = std::stoll(buffer, &idx, 10);
-#elif defined(__GNUC__)
-      i64 = __gnu_cxx::__stoa(&std::strtoll, "stoll", buffer.data(), &idx, 10);
-#else
-#error "complier no support"
-#endif
-      if (i64 <= std::numeric_limits<int32_t>::max() &&
-          i64 >= std::numeric_limits<int32_t>::min()) {
-        CALL(handler.Int32(static_cast<int32_t>(i64)));
-      } else {
-        CALL(handler.Int64(i64));
-      }
-    }
-  } catch (...) {
-    throw Exception(error::NUMBER_TOO_BIG);
+  if (std::isinf(d)) {
+    return error::NUMBER_TOO_BIG;
   }
+  CALL(handler.Double(internal::Double(minus ? -d : d)));
+  return error::OK;
 }
 
-template <required::read_stream::HasAllRequiredFunctions ReadStream,
+template <unsigned Flags,
+          required::read_stream::HasAllRequiredFunctions ReadStream,
           required::handler::HasAllRequiredFunctions Handler>
-void Reader::ParseString(ReadStream &rs, Handler &handler, const bool is_key) {
+error::ParseError Reader::ParseString(ReadStream &rs, Handler &handler,
+                                      std::string &buffer, const bool is_key) {
   rs.assertNext('"');
-  std::string buffer;
-  while (rs.hasNext()) {
-    switch (char ch = rs.next()) {
-    case '"':
-      if (is_key) {
-        CALL(handler.Key(std::move(buffer)));
-      } else {
-        CALL(handler.String(std::move(buffer)));
+  if constexpr (required::read_stream::IsInsitu<ReadStream>) {
+    internal::InsituBuffer insitu_buffer(rs.getMutableAddr());
+    return ParseStringTo<Flags>(rs, handler, insitu_buffer, is_key);
+  } else {
+    buffer.clear();
+    return ParseStringTo<Flags>(rs, handler, buffer, is_key);
+  }
+}
+
+/**
+ * @brief Parse a string body after the opening quote, unescaping it into
+ * buffer: the parse's scratch string, or the input itself for in-situ streams.
+ */
+template <unsigned Flags,
+          required::read_stream::HasAllRequiredFunctions ReadStream,
+          required::handler::HasAllRequiredFunctions Handler, typename Buffer>
+error::ParseError Reader::ParseStringTo(ReadStream &rs, Handler &handler,
+                                        Buffer &buffer, const bool is_key) {
+  const auto emit = [&handler, is_key](const std::string_view str) {
+    return is_key ? handler.Key(str) : handler.String(str);
+  };
+
+  if constexpr (required::read_stream::IsContiguous<ReadStream>) {
+    // the SIMD kernel finds the end of every verbatim run, which is copied at
+    // once: characters are only looked at one by one inside escapes
+    while (true) {
+      const char *run = rs.getAddr();
+      const char *p = ScanString(rs);
+      // runs end at ASCII, so a sequence cut short by the end of one is
+      // ill-formed and the byte ending the run is at fault
+      if constexpr ((Flags & ParseFlags::kValidateUtf8) != 0) {
+        if (const char *fault = internal::ValidateUtf8(run, p);
+            fault != nullptr) [[unlikely]] {
+          rs.setAddr(fault);
+          return error::BAD_STRING_UTF8;
+        }
       }
-      return;
-#if defined(__clang__) || defined(__GNUC__)
-    case '\x01' ... '\x1f':
-      throw Exception(error::BAD_STRING_CHAR);
-#endif
-    case '\\':
-      switch (rs.next()) {
-      case '"':
-        buffer.push_back('"');
-        break;
-      case '\\':
-        buffer.push_back('\\');
-        break;
-      case '/':
-        buffer.push_back('/');
-        break;
-      case 'b':
-        buffer.push_back('\b');
-        break;
-      case 'f':
-        buffer.push_back('\f');
-        break;
-      case 'n':
-        buffer.push_back('\n');
-        break;
-      case 'r':
-        buffer.push_back('\r');
-        break;
-      case 't':
-        buffer.push_back('\t');
-        break;
-      case 'u': {
-        // unicode stuff from Milo's tutorial
-        unsigned u = ParseHex4(rs);
-        if (u >= 0xD800 && u <= 0xDBFF) {
-          if (rs.next() != '\\') {
-            throw Exception(error::BAD_UNICODE_SURROGATE);
-          }
-          if (rs.next() != 'u') {
-            throw Exception(error::BAD_UNICODE_SURROGATE);
-          }
-          if (const unsigned u2 = ParseHex4(rs); u2 >= 0xDC00 && u2 <= 0xDFFF) {
-            u = 0x10000 + (u - 0xD800) * 0x400 + (u2 - 0xDC00);
-          } else {
-            throw Exception(error::BAD_UNICODE_SURROGATE);
-          }
+      if (p == rs.getEnd()) {
+        rs.setAddr(p);
+        return error::MISS_QUOTATION_MARK;
+      }
+      if (*p == '"') {
+        rs.setAddr(p + 1);
+        // nothing unescaped so far: hand the string out straight from the
+        // input
+        if (buffer.empty()) {
+          CALL(emit(std::string_view(run, static_cast<std::size_t>(p - run))));
+        } else {
+          buffer.append(run, p);
+          CALL(emit(std::string_view(buffer)));
         }
-        EncodeUtf8(buffer, u);
-        break;
+        return error::OK;
+      }
+      buffer.append(run, p);
+      rs.setAddr(p);
+      if (*p != '\\') {
+        return error::BAD_STRING_CHAR;
+      }
+      rs.next();
+      TRY(ParseEscape<Flags>(rs, buffer));
+    }
+  } else {
+    // every byte is peeked before it is taken, so on an error the stream is
+    // left at the byte at fault like the cursor above
+    while (rs.hasNext()) {
+      const char ch = rs.peek();
+      if (ch == '"') {
+        rs.next();
+        CALL(emit(std::string_view(buffer)));
+        return error::OK;
       }
-      default:
-        throw Exception(error::BAD_STRING_ESCAPE);
+      if (ch == '\\') {
+        rs.next();
+        TRY(ParseEscape<Flags>(rs, buffer));
+        continue;
       }
-      break;
-    default:
-#if defined(_MSC_VER)
       if (static_cast<unsigned char>(ch) < 0x20) {
-        throw Exception(error::BAD_STRING_CHAR);
+        return error::BAD_STRING_CHAR;
       }
-#endif
-      buffer.push_back(ch);
+      if constexpr ((Flags & ParseFlags::kValidateUtf8) != 0) {
+        if (static_cast<unsigned char>(ch) >= 0x80) {
+          TRY(ParseUtf8Sequence(rs, buffer));
+          continue;
+        }
+      }
+      buffer.push_back(rs.next());
     }
+    return error::MISS_QUOTATION_MARK;
   }
-  throw Exception(error::MISS_QUOTATION_MARK);
 }
 
-template <required::read_stream::HasAllRequiredFunctions ReadStream,
-          required::handler::HasAllRequiredFunctions Handler>
-void Reader::ParseArray(ReadStream &rs, Handler &handler) {
-  CALL(handler.StartArray());
-
-  rs.assertNext('[');
-  ParseWhitespace(rs);
-  if (rs.peek() == ']') {
-    rs.next();
-    CALL(handler.EndArray());
-    return;
+/**
+ * @brief Copy the UTF-8 sequence at a non-ASCII byte into buffer, stopping at
+ * the byte at fault as internal::ValidateUtf8 reports it if it is ill-formed.
+ */
+template <required::read_stream::HasAllRequiredFunctions ReadStream>
+error::ParseError Reader::ParseUtf8Sequence(ReadStream &rs,
+                                            std::string &buffer) {
+  const internal::Utf8Lead lead =
+      internal::DecodeUtf8Lead(static_cast<unsigned char>(rs.peek()));
+  if (lead.length == 0) [[unlikely]] {
+    return error::BAD_STRING_UTF8;
+  }
+  buffer.push_back(rs.next());
+  for (std::size_t i = 1; i < lead.length; ++i) {
+    if (!rs.hasNext()) [[unlikely]] {
+      return error::BAD_STRING_UTF8;
+    }
+    const auto byte = static_cast<unsigned char>(rs.peek());
+    if (byte < (i == 1 ? lead.lower : 0x80) ||
+        byte > (i == 1 ? lead.upper : 0xBF)) [[unlikely]] {
+      return error::BAD_STRING_UTF8;
+    }
+    buffer.push_back(rs.next());
   }
+  return error::OK;
+}
 
-  while (true) {
-    ParseValue(rs, handler);
-    ParseWhitespace(rs);
-    switch (rs.next()) {
-    case ',':
-      ParseWhitespace(rs);
-      break;
-    case ']':
-      CALL(handler.EndArray());
-      return;
-    default:
-      throw Exception(error::MISS_COMMA_OR_SQUARE_BRACKET);
+/**
+ * @brief Unescape the escape sequence following a backslash into buffer.
+ */
+template <unsigned Flags,
+          required::read_stream::HasAllRequiredFunctions ReadStream,
+          typename Buffer>
+error::ParseError Reader::ParseEscape(ReadStream &rs, Buffer &buffer) {
+  switch (rs.next()) {
+  case '"':
+    buffer.push_back('"');
+    break;
+  case '\\':
+    buffer.push_back('\\');
+    break;
+  case '/':
+    buffer.push_back('/');
+    break;
+  case 'b':
+    buffer.push_back('\b');
+    break;
+  case 'f':
+    buffer.push_back('\f');
+    break;
+  case 'n':
+    buffer.push_back('\n');
+    break;
+  case 'r':
+    buffer.push_back('\r');
+    break;
+  case 't':
+    buffer.push_back('\t');
+    break;
+  case 'u': {
+    // unicode stuff from Milo's tutorial
+    unsigned u;
+    TRY(ParseHex4(rs, &u));
+    if (u >= 0xD800 && u <= 0xDBFF) {
+      if (rs.next() != '\\') {
+        return error::BAD_UNICODE_SURROGATE;
+      }
+      if (rs.next() != 'u') {
+        return error::BAD_UNICODE_SURROGATE;
+      }
+      unsigned u2;
+      TRY(ParseHex4(rs, &u2));
+      if (u2 < 0xDC00 || u2 > 0xDFFF) {
+        return error::BAD_UNICODE_SURROGATE;
+      }
+      u = 0x10000 + (u - 0xD800) * 0x400 + (u2 - 0xDC00);
+    } else if constexpr ((Flags & ParseFlags::kValidateUtf8) != 0) {
+      // a lone low surrogate has no UTF-8 encoding
+      if (u >= 0xDC00 && u <= 0xDFFF) {
+        return error::BAD_UNICODE_SURROGATE;
+      }
     }
+    EncodeUtf8(buffer, u);
+    break;
+  }
+  default:
+    return error::BAD_STRING_ESCAPE;
   }
+  return error::OK;
 }
 
-template <required::read_stream::HasAllRequiredFunctions ReadStream,
+/**
+ * @brief Parse an object member up to its value: the key, the colon and the
+ * whitespace around it.
+ */
+template <unsigned Flags,
+          required::read_stream::HasAllRequiredFunctions ReadStream,
           required::handler::HasAllRequiredFunctions Handler>
-void Reader::ParseObject(ReadStream &rs, Handler &handler) {
-  CALL(handler.StartObject());
-
-  rs.assertNext('{');
-  ParseWhitespace(rs);
-  if (rs.peek() == '}') {
-    rs.next();
-    CALL(handler.EndObject());
-    return;
+error::ParseError Reader::ParseKey(ReadStream &rs, Handler &handler,
+                                   std::string &buffer) {
+  if (rs.peek() != '"') {
+    return error::MISS_KEY;
   }
+  TRY(ParseString<Flags>(rs, handler, buffer, true));
 
-  while (true) {
-    if (rs.peek() != '"') {
-      throw Exception(error::MISS_KEY);
-    }
-
-    ParseString(rs, handler, true);
-
-    // parse ':'
-    ParseWhitespace(rs);
-    if (rs.next() != ':') {
-      throw Exception(error::MISS_COLON);
-    }
-    ParseWhitespace(rs);
-
-    // go on
-    ParseValue(rs, handler);
-    ParseWhitespace(rs);
-    switch (rs.next()) {
-    case ',':
-      ParseWhitespace(rs);
-      break;
-    case '}':
-      CALL(handler.EndObject());
-      return;
-    default:
-      throw Exception(error::MISS_COMMA_OR_CURLY_BRACKET);
-    }
+  // parse ':'
+  ParseWhitespace(rs);
+  if (rs.peek() != ':') {
+    return error::MISS_COLON;
   }
+  rs.next();
+  ParseWhitespace(rs);
+  return error::OK;
 }
 
-#undef CALL
-
-template <required::read_stream::HasAllRequiredFunctions ReadStream,
+template <unsigned Flags,
+          required::read_stream::HasAllRequiredFunctions ReadStream,
           required::handler::HasAllRequiredFunctions Handler>
-void Reader::ParseValue(ReadStream &rs, Handler &handler) {
-  if (!rs.hasNext()) {
-    throw Exception(error::EXPECT_VALUE);
-  }
-
+error::ParseError Reader::ParseScalar(ReadStream &rs, Handler &handler,
+                                      std::string &buffer) {
   switch (rs.peek()) {
   case 'n':
     return ParseLiteral(rs, handler, "null", NEU_NULL);
@@ -663,17 +826,90 @@ void Reader::ParseValue(ReadStream &rs, Handler &handler) {
   case 'f':
     return ParseLiteral(rs, handler, "false", NEU_BOOL);
   case '"':
-    return ParseString(rs, handler, false);
-  case '[':
-    return ParseArray(rs, handler);
-  case '{':
-    return ParseObject(rs, handler);
+    return ParseString<Flags>(rs, handler, buffer, false);
   default:
-    return ParseNumber(rs, handler);
+    return ParseNumber<Flags>(rs, handler, buffer);
+  }
+}
+
+/**
+ * @brief Parse a value of any depth without recursion. Open arrays and objects
+ * live on an explicit stack of one byte per level, so nesting costs no call
+ * frames and the depth limit is a single comparison.
+ * @tparam ReadStream
+ * @tparam Handler
+ * @param rs
+ * @param handler
+ * @param buffer
+ * @return
+ */
+template <unsigned Flags,
+          required::read_stream::HasAllRequiredFunctions ReadStream,
+          required::handler::HasAllRequiredFunctions Handler>
+error::ParseError Reader::ParseValue(ReadStream &rs, Handler &handler,
+                                     std::string &buffer) {
+  static_assert(NEUJSON_PARSE_MAX_DEPTH > 0, "bad NEUJSON_PARSE_MAX_DEPTH");
+
+  // '[' or '{' for every open container, innermost last
+  char stack[NEUJSON_PARSE_MAX_DEPTH];
+  std::size_t depth = 0;
+
+  while (true) {
+    // a value starts here, whitespace is already skipped
+    if (!rs.hasNext()) {
+      return error::EXPECT_VALUE;
+    }
+    if (const char ch = rs.peek(); ch == '[' || ch == '{') {
+      if (depth == NEUJSON_PARSE_MAX_DEPTH) [[unlikely]] {
+        return error::DEPTH_EXCEEDED;
+      }
+      const bool is_array = ch == '[';
+      CALL(is_array ? handler.StartArray() : handler.StartObject());
+      rs.next();
+      ParseWhitespace(rs);
+      if (rs.peek() != (is_array ? ']' : '}')) {
+        stack[depth++] = ch;
+        if (!is_array) {
+          TRY(ParseKey<Flags>(rs, handler, buffer));
+        }
+        continue;
+      }
+      rs.next();
+      CALL(is_array ? handler.EndArray() : handler.EndObject());
+    } else {
+      TRY(ParseScalar<Flags>(rs, handler, buffer));
+    }
+
+    // the value is complete, close the containers it completes
+    while (true) {
+      if (depth == 0) {
+        return error::OK;
+      }
+      const bool in_array = stack[depth - 1] == '[';
+      ParseWhitespace(rs);
+      // errors point at the unexpected byte, so it is only taken when expected
+      const char ch = rs.peek();
+      if (ch == ',') {
+        rs.next();
+        ParseWhitespace(rs);
+        if (!in_array) {
+          TRY(ParseKey<Flags>(rs, handler, buffer));
+        }
+        break;
+      }
+      if (ch != (in_array ? ']' : '}')) {
+        return in_array ? error::MISS_COMMA_OR_SQUARE_BRACKET
+                        : error::MISS_COMMA_OR_CURLY_BRACKET;
+      }
+      rs.next();
+      depth--;
+      CALL(in_array ? handler.EndArray() : handler.EndObject());
+    }
   }
 }
 
-inline void Reader::EncodeUtf8(std::string &buffer, const unsigned int u) {
+template <typename Buffer>
+void Reader::EncodeUtf8(Buffer &buffer, const unsigned int u) {
   if (u <= 0x7F) {
     buffer.push_back(static_cast<char>(u & 0xFF));
   } else if (u <= 0x7FF) {
@@ -692,14 +928,9 @@ inline void Reader::EncodeUtf8(std::string &buffer, const unsigned int u) {
   }
 }
 
-} // namespace neujson
+#undef CALL
+#undef TRY
 
-#if defined(NEUJSON_SSE42_OFF)
-#define NEUJSON_SSE42
-#elif defined(NEUJSON_SSE2_OFF)
-#define NEUJSON_SSE2
-#elif defined(NEUJSON_NEON_OFF)
-#define NEUJSON_NEON
-#endif
+} // namespace neujson
 
 #endif // NEUJSON_NEUJSON_READER_H_
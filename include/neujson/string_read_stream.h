@@ -13,41 +13,35 @@
 namespace neujson {
 
 class StringReadStream : public NonCopyable {
-public:
-  using Iterator = std::string_view::iterator;
-
-private:
-  std::string_view json_;
-  Iterator iter_;
+  const char *current_;
+  const char *end_;
 
 public:
   explicit StringReadStream(const std::string_view json)
-      : json_(json), iter_(json_.begin()) {}
+      : current_(json.data()), end_(json.data() + json.size()) {}
 
-  [[nodiscard]] bool hasNext() const { return iter_ != json_.end(); }
+  [[nodiscard]] bool hasNext() const { return current_ != end_; }
 
-  [[nodiscard]] char peek() const { return hasNext() ? *iter_ : '\0'; }
+  [[nodiscard]] char peek() const { return hasNext() ? *current_ : '\0'; }
 
   char next() {
     if (hasNext()) {
-      const char ch = *iter_;
-      iter_++;
-      return ch;
+      return *current_++;
     }
     return '\0';
   }
 
   std::string_view next(const std::size_t n) {
-    auto start = iter_;
-    if (static_cast<std::size_t>(std::distance(iter_, json_.end())) >= n) {
-      std::advance(iter_, n);
+    const char *start = current_;
+    if (static_cast<std::size_t>(end_ - current_) >= n) {
+      current_ += n;
     }
-    return {start, iter_};
+    return {start, static_cast<std::size_t>(current_ - start)};
   }
 
   void skip(const std::size_t n) {
-    if (static_cast<std::size_t>(std::distance(iter_, json_.end())) >= n) {
-      std::advance(iter_, n);
+    if (static_cast<std::size_t>(end_ - current_) >= n) {
+      current_ += n;
     }
   }
 
@@ -56,6 +50,14 @@ public:
     NEUJSON_ASSERT(peek() == ch);
     next();
   }
+
+  // contiguous input, see required::read_stream::IsContiguous
+  [[nodiscard]] const char *getAddr() const { return current_; }
+  [[nodiscard]] const char *getEnd() const { return end_; }
+  void setAddr(const char *addr) {
+    NEUJSON_ASSERT(addr >= current_ && addr <= end_);
+    current_ = addr;
+  }
 };
 
 } // namespace neujson
@@ -0,0 +1,246 @@
+#ifndef NEUJSON_NEUJSON_STRUCTURAL_READER_H_
+#define NEUJSON_NEUJSON_STRUCTURAL_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "exception.h"
+#include "internal/cursor.h"
+#include "internal/structural_index.h"
+#include "non_copyable.h"
+#include "reader.h"
+
+namespace neujson {
+
+/**
+ * @brief Two-stage parser for contiguous input. Stage one,
+ * internal::StructuralIndexer, runs over the whole buffer with the SIMD
+ * kernels and records where every token starts; stage two walks those
+ * positions and drives the handler exactly like Reader::Parse() would, with
+ * the same flags, events and error codes. Whitespace is never looked at
+ * again, and neither are the bodies of strings until their values are read.
+ *
+ * The index takes four bytes per input byte. It is kept by the reader and
+ * reused by the next Parse(), as is the scratch space for strings with
+ * escapes, so one reader per thread parsing many documents allocates only
+ * when the input grows.
+ */
+class StructuralReader : NonCopyable {
+  std::unique_ptr<uint32_t[]> index_;
+  std::size_t capacity_ = 0;
+  std::string scratch_;
+
+public:
+  template <unsigned Flags = ParseFlags::kDefault,
+            required::read_stream::IsContiguous ReadStream,
+            required::handler::HasAllRequiredFunctions Handler>
+  [[nodiscard]] ParseResult Parse(ReadStream &rs, Handler &handler);
+
+private:
+  template <unsigned Flags,
+            required::read_stream::IsContiguous ReadStream,
+            required::handler::HasAllRequiredFunctions Handler>
+  [[nodiscard]] error::ParseError ParseRoot(ReadStream &rs, Handler &handler);
+
+  template <unsigned Flags,
+            required::read_stream::IsContiguous ReadStream,
+            required::handler::HasAllRequiredFunctions Handler>
+  [[nodiscard]] static error::ParseError
+  ParseIndexed(ReadStream &rs, Handler &handler, const uint32_t *index,
+               const uint32_t *index_end, std::string &buffer);
+
+  // whether the byte at the stream position may follow a complete value
+  template <required::read_stream::IsContiguous ReadStream>
+  static bool IsValueEnd(const ReadStream &rs);
+};
+
+template <unsigned Flags, required::read_stream::IsContiguous ReadStream,
+          required::handler::HasAllRequiredFunctions Handler>
+ParseResult StructuralReader::Parse(ReadStream &rs, Handler &handler) {
+  // offsets are 32-bit, larger input goes through the one-pass reader
+  if (static_cast<std::size_t>(rs.getEnd() - rs.getAddr()) >
+      std::numeric_limits<uint32_t>::max()) [[unlikely]] {
+    return Reader::Parse<Flags>(rs, handler, scratch_);
+  }
+  if constexpr (required::read_stream::IsInsitu<ReadStream>) {
+    internal::InsituCursor cursor(rs.getMutableAddr(), rs.getEnd());
+    const auto err = ParseRoot<Flags>(cursor, handler);
+    const auto offset = cursor.getAddr() - rs.getAddr();
+    rs.setAddr(cursor.getAddr());
+    return {err, static_cast<std::size_t>(offset)};
+  } else if constexpr (required::read_stream::IsPadded<ReadStream>) {
+    internal::PaddedCursor cursor(rs.getAddr(), rs.getEnd());
+    const auto err = ParseRoot<Flags>(cursor, handler);
+    const auto offset = cursor.getAddr() - rs.getAddr();
+    rs.setAddr(cursor.getAddr());
+    return {err, static_cast<std::size_t>(offset)};
+  } else {
+    internal::Cursor cursor(rs.getAddr(), rs.getEnd());
+    const auto err = ParseRoot<Flags>(cursor, handler);
+    const auto offset = cursor.getAddr() - rs.getAddr();
+    rs.setAddr(cursor.getAddr());
+    return {err, static_cast<std::size_t>(offset)};
+  }
+}
+
+template <unsigned Flags, required::read_stream::IsContiguous ReadStream,
+          required::handler::HasAllRequiredFunctions Handler>
+error::ParseError StructuralReader::ParseRoot(ReadStream &rs,
+                                              Handler &handler) {
+  const auto length = static_cast<std::size_t>(rs.getEnd() - rs.getAddr());
+  if (capacity_ < length) {
+    // no value-initialization, stage one writes every offset it reads back
+    index_.reset(new uint32_t[length]);
+    capacity_ = length;
+  }
+  internal::StructuralIndexer indexer;
+  const std::size_t count =
+      indexer.Index(rs.getAddr(), rs.getEnd(), index_.get());
+  return ParseIndexed<Flags>(rs, handler, index_.get(), index_.get() + count,
+                             scratch_);
+}
+
+template <required::read_stream::IsContiguous ReadStream>
+bool StructuralReader::IsValueEnd(const ReadStream &rs) {
+  switch (rs.peek()) {
+  case ' ':
+  case '\n':
+  case '\r':
+  case '\t':
+  case ',':
+  case ':':
+  case '[':
+  case ']':
+  case '{':
+  case '}':
+    return true;
+  default:
+    return !rs.hasNext();
+  }
+}
+
+#define TRY(_expr)                                                             \
+  if (const auto err_ = (_expr); err_ != error::OK) [[unlikely]]               \
+  return err_
+
+#define CALL(_expr)                                                            \
+  if (!(_expr)) [[unlikely]]                                                   \
+  return error::USER_STOPPED
+
+/**
+ * @brief Stage two, Reader::ParseValue() over the structural positions. The
+ * tokens themselves are read by the Reader's own functions; moving to the
+ * next position replaces skipping whitespace. A literal or number may end in
+ * a byte stage one did not index, such as the quote of "[1\"a\"]", so values
+ * not followed by whitespace or a structural character are rejected as the
+ * Reader would reject the byte after them.
+ */
+template <unsigned Flags, required::read_stream::IsContiguous ReadStream,
+          required::handler::HasAllRequiredFunctions Handler>
+error::ParseError StructuralReader::ParseIndexed(ReadStream &rs,
+                                                 Handler &handler,
+                                                 const uint32_t *index,
+                                                 const uint32_t *index_end,
+                                                 std::string &buffer) {
+  static_assert(NEUJSON_PARSE_MAX_DEPTH > 0, "bad NEUJSON_PARSE_MAX_DEPTH");
+
+  const char *begin = rs.getAddr();
+  const char *end = rs.getEnd();
+  // the next structural position, the end of input after the last one
+  const auto advance = [&] {
+    rs.setAddr(index != index_end ? begin + *index++ : end);
+  };
+
+  buffer.clear();
+  // '[' or '{' for every open container, innermost last
+  char stack[NEUJSON_PARSE_MAX_DEPTH];
+  std::size_t depth = 0;
+
+  // a key starts at the stream position, stop at the start of its value
+  const auto parse_key = [&]() -> error::ParseError {
+    if (rs.peek() != '"') {
+      return error::MISS_KEY;
+    }
+    TRY(Reader::ParseString<Flags>(rs, handler, buffer, true));
+    advance();
+    if (rs.peek() != ':') {
+      return error::MISS_COLON;
+    }
+    advance();
+    return error::OK;
+  };
+
+  advance();
+  while (true) {
+    // a value starts here
+    if (!rs.hasNext()) {
+      return error::EXPECT_VALUE;
+    }
+    if (const char ch = rs.peek(); ch == '[' || ch == '{') {
+      if (depth == NEUJSON_PARSE_MAX_DEPTH) [[unlikely]] {
+        return error::DEPTH_EXCEEDED;
+      }
+      const bool is_array = ch == '[';
+      CALL(is_array ? handler.StartArray() : handler.StartObject());
+      advance();
+      if (rs.peek() != (is_array ? ']' : '}')) {
+        stack[depth++] = ch;
+        if (!is_array) {
+          TRY(parse_key());
+        }
+        continue;
+      }
+      rs.next();
+      CALL(is_array ? handler.EndArray() : handler.EndObject());
+    } else {
+      TRY(Reader::ParseScalar<Flags>(rs, handler, buffer));
+    }
+
+    // the value is complete, close the containers it completes
+    while (true) {
+      if (depth == 0) {
+        if constexpr ((Flags & ParseFlags::kStopWhenDone) == 0) {
+          if (!IsValueEnd(rs)) {
+            return error::ROOT_NOT_SINGULAR;
+          }
+          advance();
+          if (rs.hasNext()) {
+            return error::ROOT_NOT_SINGULAR;
+          }
+        }
+        return error::OK;
+      }
+      const bool in_array = stack[depth - 1] == '[';
+      // errors point at the unexpected byte, so it is only taken when expected
+      if (IsValueEnd(rs)) {
+        advance();
+      }
+      const char ch = rs.peek();
+      if (ch == ',') {
+        advance();
+        if (!in_array) {
+          TRY(parse_key());
+        }
+        break;
+      }
+      if (ch != (in_array ? ']' : '}')) {
+        return in_array ? error::MISS_COMMA_OR_SQUARE_BRACKET
+                        : error::MISS_COMMA_OR_CURLY_BRACKET;
+      }
+      rs.next();
+      depth--;
+      CALL(in_array ? handler.EndArray() : handler.EndObject());
+    }
+  }
+}
+
+#undef CALL
+#undef TRY
+
+} // namespace neujson
+
+#endif // NEUJSON_NEUJSON_STRUCTURAL_READER_H_
@@ -0,0 +1,560 @@
+#ifndef NEUJSON_NEUJSON_TAPE_DOCUMENT_H_
+#define NEUJSON_NEUJSON_TAPE_DOCUMENT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "exception.h"
+#include "internal/ieee754.h"
+#include "neujson.h"
+#include "reader.h"
+#include "string_read_stream.h"
+#include "value.h"
+
+namespace neujson {
+
+namespace internal {
+
+/**
+ * @brief Words of a TapeDocument's tape: the Type in the top byte and a 56-bit
+ * payload. Booleans and 32-bit integers are the payload; 64-bit integers and
+ * doubles take the next word whole; strings and keys are the offset of their
+ * length and characters in the string arena; arrays and objects are the
+ * index just past their last element in the low 32 bits and how many elements
+ * or members they have in the upper 24, saturated.
+ */
+struct Tape {
+  static constexpr int kTypeShift = 56;
+  static constexpr uint64_t kPayloadMask = (uint64_t{1} << kTypeShift) - 1;
+  static constexpr uint64_t kEndMask = 0xffffffff;
+  static constexpr int kCountShift = 32;
+  static constexpr uint64_t kCountSaturated = 0xffffff;
+
+  static uint64_t Word(const Type type, const uint64_t payload) {
+    return static_cast<uint64_t>(type) << kTypeShift | payload;
+  }
+  static Type TypeOf(const uint64_t word) {
+    return static_cast<Type>(word >> kTypeShift);
+  }
+  static uint64_t PayloadOf(const uint64_t word) {
+    return word & kPayloadMask;
+  }
+};
+
+} // namespace internal
+
+class TapeDocument;
+struct TapeMember;
+
+/**
+ * @brief Read-only view of a value on the tape of a TapeDocument, as cheap to
+ * copy as a pointer and valid as long as the document is neither parsed into
+ * again nor destroyed. The accessors mirror those of Value.
+ */
+class TapeValue {
+  friend class TapeDocument;
+
+  const uint64_t *tape_ = nullptr;
+  const char *strings_ = nullptr;
+  std::size_t index_ = 0;
+
+  TapeValue(const uint64_t *tape, const char *strings, const std::size_t index)
+      : tape_(tape), strings_(strings), index_(index) {}
+
+public:
+  class ElementIterator;
+  class MemberIterator;
+  template <typename Iterator> class Range;
+
+  TapeValue() = default;
+
+  [[nodiscard]] Type GetType() const {
+    return internal::Tape::TypeOf(tape_[index_]);
+  }
+  [[nodiscard]] std::size_t GetSize() const;
+
+  [[nodiscard]] bool IsNull() const { return GetType() == NEU_NULL; }
+  [[nodiscard]] bool IsBool() const { return GetType() == NEU_BOOL; }
+  [[nodiscard]] bool IsInt32() const { return GetType() == NEU_INT32; }
+  [[nodiscard]] bool IsInt64() const {
+    return GetType() == NEU_INT64 || GetType() == NEU_INT32;
+  }
+  [[nodiscard]] bool IsDouble() const { return GetType() == NEU_DOUBLE; }
+  [[nodiscard]] bool IsString() const { return GetType() == NEU_STRING; }
+  [[nodiscard]] bool IsArray() const { return GetType() == NEU_ARRAY; }
+  [[nodiscard]] bool IsObject() const { return GetType() == NEU_OBJECT; }
+
+  [[nodiscard]] bool GetBool() const {
+    NEUJSON_ASSERT(GetType() == NEU_BOOL);
+    return payload() != 0;
+  }
+  [[nodiscard]] int32_t GetInt32() const {
+    NEUJSON_ASSERT(GetType() == NEU_INT32);
+    return static_cast<int32_t>(static_cast<uint32_t>(payload()));
+  }
+  [[nodiscard]] int64_t GetInt64() const {
+    NEUJSON_ASSERT(GetType() == NEU_INT64 || GetType() == NEU_INT32);
+    return GetType() == NEU_INT64 ? static_cast<int64_t>(tape_[index_ + 1])
+                                  : GetInt32();
+  }
+  [[nodiscard]] double GetDouble() const {
+    NEUJSON_ASSERT(GetType() == NEU_DOUBLE);
+    return internal::Double(tape_[index_ + 1]).Value();
+  }
+  [[nodiscard]] std::string_view GetStringView() const {
+    NEUJSON_ASSERT(GetType() == NEU_STRING);
+    const char *p = strings_ + payload();
+    uint32_t length;
+    std::memcpy(&length, p, sizeof(length));
+    return {p + sizeof(length), length};
+  }
+  [[nodiscard]] std::string GetString() const {
+    return std::string(GetStringView());
+  }
+
+  [[nodiscard]] Range<ElementIterator> GetArray() const;
+  [[nodiscard]] Range<MemberIterator> GetObject() const;
+
+  // walks the array, elements are not indexed
+  [[nodiscard]] TapeValue operator[](std::size_t index) const;
+  [[nodiscard]] TapeValue operator[](std::string_view key) const;
+
+  [[nodiscard]] MemberIterator MemberBegin() const;
+  [[nodiscard]] MemberIterator MemberEnd() const;
+  [[nodiscard]] MemberIterator FindMember(std::string_view key) const;
+
+  template <required::handler::HasAllRequiredFunctions Handler>
+  bool WriteTo(Handler &handler) const;
+
+private:
+  [[nodiscard]] uint64_t payload() const {
+    return internal::Tape::PayloadOf(tape_[index_]);
+  }
+  // the index just past an array or object
+  [[nodiscard]] std::size_t end() const {
+    return payload() & internal::Tape::kEndMask;
+  }
+  // the index of the value following this one
+  [[nodiscard]] std::size_t next() const {
+    switch (GetType()) {
+    case NEU_INT64:
+    case NEU_DOUBLE:
+      return index_ + 2;
+    case NEU_ARRAY:
+    case NEU_OBJECT:
+      return end();
+    default:
+      return index_ + 1;
+    }
+  }
+};
+
+struct TapeMember {
+  TapeValue key_;
+  TapeValue value_;
+};
+
+class TapeValue::ElementIterator {
+  TapeValue value_;
+
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = TapeValue;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const TapeValue *;
+  using reference = const TapeValue &;
+
+  ElementIterator() = default;
+  explicit ElementIterator(const TapeValue value) : value_(value) {}
+
+  reference operator*() const { return value_; }
+  pointer operator->() const { return &value_; }
+
+  ElementIterator &operator++() {
+    value_.index_ = value_.next();
+    return *this;
+  }
+  ElementIterator operator++(int) {
+    auto it = *this;
+    ++*this;
+    return it;
+  }
+
+  bool operator==(const ElementIterator &rhs) const {
+    return value_.index_ == rhs.value_.index_;
+  }
+};
+
+class TapeValue::MemberIterator {
+  TapeMember member_;
+
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = TapeMember;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const TapeMember *;
+  using reference = const TapeMember &;
+
+  MemberIterator() = default;
+  // key is where the member starts, the value follows its single word
+  explicit MemberIterator(const TapeValue key)
+      : member_{key, TapeValue(key.tape_, key.strings_, key.index_ + 1)} {}
+
+  reference operator*() const { return member_; }
+  pointer operator->() const { return &member_; }
+
+  MemberIterator &operator++() {
+    member_.key_.index_ = member_.value_.next();
+    member_.value_.index_ = member_.key_.index_ + 1;
+    return *this;
+  }
+  MemberIterator operator++(int) {
+    auto it = *this;
+    ++*this;
+    return it;
+  }
+
+  bool operator==(const MemberIterator &rhs) const {
+    return member_.key_.index_ == rhs.member_.key_.index_;
+  }
+};
+
+template <typename Iterator> class TapeValue::Range {
+  Iterator begin_;
+  Iterator end_;
+
+public:
+  Range(Iterator begin, Iterator end) : begin_(begin), end_(end) {}
+
+  [[nodiscard]] Iterator begin() const { return begin_; }
+  [[nodiscard]] Iterator end() const { return end_; }
+  [[nodiscard]] bool empty() const { return begin_ == end_; }
+};
+
+/**
+ * @brief Immutable alternative to Document: the parse result is kept in two
+ * flat buffers, a tape of 64-bit words in document order and an arena with
+ * the characters of every string and key, rather than a tree of Values.
+ * Building it appends to the two buffers, destroying it frees them, and
+ * reading it walks them front to back; an array or object records where it
+ * ends so that it is skipped in one step. Both buffers keep their capacity
+ * when the document is parsed into again.
+ */
+class TapeDocument {
+  struct Level {
+    std::size_t start;
+    uint64_t count;
+  };
+
+  std::vector<uint64_t> tape_{internal::Tape::Word(NEU_NULL, 0)};
+  std::string strings_;
+  std::vector<Level> stack_;
+  // the Reader's scratch space for strings with escapes, kept across parses
+  std::string scratch_;
+
+public:
+  template <unsigned Flags = ParseFlags::kDefault>
+  [[nodiscard]] ParseResult Parse(const char *json, size_t len);
+  template <unsigned Flags = ParseFlags::kDefault>
+  [[nodiscard]] ParseResult Parse(std::string_view json);
+
+  /**
+   * @brief Parse into the document, replacing what it held; it reads as
+   * null if the parse fails.
+   * @param rs
+   * @return
+   */
+  template <unsigned Flags = ParseFlags::kDefault,
+            required::read_stream::HasAllRequiredFunctions ReadStream>
+  [[nodiscard]] ParseResult ParseStream(ReadStream &rs);
+
+  [[nodiscard]] TapeValue GetRoot() const {
+    return {tape_.data(), strings_.data(), 0};
+  }
+
+  template <required::handler::HasAllRequiredFunctions Handler>
+  bool WriteTo(Handler &handler) const {
+    return GetRoot().WriteTo(handler);
+  }
+
+  // the sizes of the two buffers, in words and in bytes
+  [[nodiscard]] std::size_t TapeSize() const { return tape_.size(); }
+  [[nodiscard]] std::size_t StringsSize() const { return strings_.size(); }
+
+  // handler
+  bool Null();
+  bool Bool(bool b);
+  bool Int32(int32_t i32);
+  bool Int64(int64_t i64);
+  bool Double(internal::Double d);
+  bool String(std::string_view str);
+  bool Key(std::string_view str);
+  bool StartObject();
+  bool EndObject();
+  bool StartArray();
+  bool EndArray();
+
+private:
+  void AddWord(Type type, uint64_t payload);
+  void AddString(std::string_view str);
+  void StartContainer(Type type);
+  void EndContainer(Type type);
+};
+
+inline std::size_t TapeValue::GetSize() const {
+  switch (GetType()) {
+  case NEU_ARRAY:
+  case NEU_OBJECT: {
+    const uint64_t count = payload() >> internal::Tape::kCountShift;
+    if (count < internal::Tape::kCountSaturated) {
+      return count;
+    }
+    if (GetType() == NEU_ARRAY) {
+      const auto array = GetArray();
+      return static_cast<std::size_t>(
+          std::distance(array.begin(), array.end()));
+    }
+    const auto object = GetObject();
+    return static_cast<std::size_t>(
+        std::distance(object.begin(), object.end()));
+  }
+  default:
+    return 1;
+  }
+}
+
+inline TapeValue::Range<TapeValue::ElementIterator>
+TapeValue::GetArray() const {
+  NEUJSON_ASSERT(GetType() == NEU_ARRAY);
+  return {ElementIterator(TapeValue(tape_, strings_, index_ + 1)),
+          ElementIterator(TapeValue(tape_, strings_, end()))};
+}
+
+inline TapeValue::Range<TapeValue::MemberIterator>
+TapeValue::GetObject() const {
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
+  return {MemberBegin(), MemberEnd()};
+}
+
+inline TapeValue TapeValue::operator[](const std::size_t index) const {
+  NEUJSON_ASSERT(GetType() == NEU_ARRAY);
+  std::size_t i = 0;
+  for (const auto value : GetArray()) {
+    if (i++ == index) {
+      return value;
+    }
+  }
+  internal::ThrowOutOfRange();
+}
+
+inline TapeValue TapeValue::operator[](const std::string_view key) const {
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
+  auto it = FindMember(key);
+  if (it != MemberEnd()) {
+    return it->value_;
+  }
+
+  NEUJSON_ASSERT(false && "value no found");
+  static constexpr uint64_t kFake = 0;
+  return {&kFake, nullptr, 0};
+}
+
+inline TapeValue::MemberIterator TapeValue::MemberBegin() const {
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
+  return MemberIterator(TapeValue(tape_, strings_, index_ + 1));
+}
+
+inline TapeValue::MemberIterator TapeValue::MemberEnd() const {
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
+  return MemberIterator(TapeValue(tape_, strings_, end()));
+}
+
+inline TapeValue::MemberIterator
+TapeValue::FindMember(const std::string_view key) const {
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
+  auto it = MemberBegin();
+  for (const auto last = MemberEnd(); it != last; ++it) {
+    if (it->key_.GetStringView() == key) {
+      break;
+    }
+  }
+  return it;
+}
+
+#define CALL_HANDLER(_expr)                                                    \
+  do {                                                                         \
+    if (!(_expr)) {                                                            \
+      return false;                                                            \
+    }                                                                          \
+  } while (false)
+
+template <required::handler::HasAllRequiredFunctions Handler>
+bool TapeValue::WriteTo(Handler &handler) const {
+  switch (GetType()) {
+  case NEU_NULL:
+    CALL_HANDLER(handler.Null());
+    break;
+  case NEU_BOOL:
+    CALL_HANDLER(handler.Bool(GetBool()));
+    break;
+  case NEU_INT32:
+    CALL_HANDLER(handler.Int32(GetInt32()));
+    break;
+  case NEU_INT64:
+    CALL_HANDLER(handler.Int64(GetInt64()));
+    break;
+  case NEU_DOUBLE:
+    CALL_HANDLER(handler.Double(internal::Double(tape_[index_ + 1])));
+    break;
+  case NEU_STRING:
+    CALL_HANDLER(handler.String(GetStringView()));
+    break;
+  case NEU_ARRAY:
+    CALL_HANDLER(handler.StartArray());
+    for (const auto value : GetArray()) {
+      CALL_HANDLER(value.WriteTo(handler));
+    }
+    CALL_HANDLER(handler.EndArray());
+    break;
+  case NEU_OBJECT:
+    CALL_HANDLER(handler.StartObject());
+    for (const auto &member : GetObject()) {
+      CALL_HANDLER(handler.Key(member.key_.GetStringView()));
+      CALL_HANDLER(member.value_.WriteTo(handler));
+    }
+    CALL_HANDLER(handler.EndObject());
+    break;
+  default:
+    NEUJSON_ASSERT(false && "bad type");
+  }
+  return true;
+}
+
+#undef CALL_HANDLER
+
+template <unsigned Flags>
+ParseResult TapeDocument::Parse(const char *json, const size_t len) {
+  return Parse<Flags>(std::string_view(json, len));
+}
+
+template <unsigned Flags>
+ParseResult TapeDocument::Parse(const std::string_view json) {
+  StringReadStream string_read_stream(json);
+  return ParseStream<Flags>(string_read_stream);
+}
+
+template <unsigned Flags,
+          required::read_stream::HasAllRequiredFunctions ReadStream>
+ParseResult TapeDocument::ParseStream(ReadStream &rs) {
+  tape_.clear();
+  strings_.clear();
+  stack_.clear();
+  const auto result = Reader::Parse<Flags>(rs, *this, scratch_);
+  if (result != error::OK || tape_.empty()) {
+    tape_.assign(1, internal::Tape::Word(NEU_NULL, 0));
+  }
+  return result;
+}
+
+inline bool TapeDocument::Null() {
+  AddWord(NEU_NULL, 0);
+  return true;
+}
+
+inline bool TapeDocument::Bool(const bool b) {
+  AddWord(NEU_BOOL, b ? 1 : 0);
+  return true;
+}
+
+inline bool TapeDocument::Int32(const int32_t i32) {
+  AddWord(NEU_INT32, static_cast<uint32_t>(i32));
+  return true;
+}
+
+inline bool TapeDocument::Int64(const int64_t i64) {
+  AddWord(NEU_INT64, 0);
+  tape_.push_back(static_cast<uint64_t>(i64));
+  return true;
+}
+
+inline bool TapeDocument::Double(const internal::Double d) {
+  AddWord(NEU_DOUBLE, 0);
+  tape_.push_back(d.UInt64Value());
+  return true;
+}
+
+inline bool TapeDocument::String(const std::string_view str) {
+  AddString(str);
+  return true;
+}
+
+inline bool TapeDocument::Key(const std::string_view str) {
+  AddString(str);
+  return true;
+}
+
+inline bool TapeDocument::StartObject() {
+  StartContainer(NEU_OBJECT);
+  return true;
+}
+
+inline bool TapeDocument::EndObject() {
+  EndContainer(NEU_OBJECT);
+  return true;
+}
+
+inline bool TapeDocument::StartArray() {
+  StartContainer(NEU_ARRAY);
+  return true;
+}
+
+inline bool TapeDocument::EndArray() {
+  EndContainer(NEU_ARRAY);
+  return true;
+}
+
+inline void TapeDocument::AddWord(const Type type, const uint64_t payload) {
+  // keys count too, an object's members are half of its count
+  if (!stack_.empty()) {
+    stack_.back().count++;
+  }
+  tape_.push_back(internal::Tape::Word(type, payload));
+}
+
+inline void TapeDocument::AddString(const std::string_view str) {
+  NEUJSON_ASSERT(str.size() <= std::numeric_limits<uint32_t>::max());
+  const auto length = static_cast<uint32_t>(str.size());
+  AddWord(NEU_STRING, strings_.size());
+  strings_.append(reinterpret_cast<const char *>(&length), sizeof(length));
+  strings_.append(str);
+}
+
+inline void TapeDocument::StartContainer(const Type type) {
+  AddWord(type, 0);
+  stack_.push_back({tape_.size() - 1, 0});
+}
+
+inline void TapeDocument::EndContainer(const Type type) {
+  NEUJSON_ASSERT(!stack_.empty());
+  const auto [start, count] = stack_.back();
+  stack_.pop_back();
+  NEUJSON_ASSERT(internal::Tape::TypeOf(tape_[start]) == type);
+  NEUJSON_ASSERT(tape_.size() <= internal::Tape::kEndMask);
+  const uint64_t members = type == NEU_OBJECT ? count / 2 : count;
+  tape_[start] = internal::Tape::Word(
+      type, std::min(members, internal::Tape::kCountSaturated)
+                    << internal::Tape::kCountShift |
+                tape_.size());
+}
+
+} // namespace neujson
+
+#endif // NEUJSON_NEUJSON_TAPE_DOCUMENT_H_
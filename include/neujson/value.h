@@ -5,20 +5,29 @@
 #ifndef NEUJSON_NEUJSON_VALUE_H_
 #define NEUJSON_NEUJSON_VALUE_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 
 #include <algorithm>
 #include <atomic>
+#include <bit>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <new>
 #include <ranges>
+#include <stdexcept>
 #include <string>
 #include <string_view>
-#include <variant>
-#include <vector>
+#include <type_traits>
+#include <utility>
 
+#include "arena.h"
 #include "internal/ieee754.h"
 #include "neujson.h"
+#include "non_copyable.h"
 
 namespace neujson {
 
@@ -92,128 +101,464 @@ concept HasAllRequiredFunctions =
 
 } // namespace required::handler
 
-#undef SUFFIX
-#define VALUE(NEU)                                                             \
-  NEU(NULL, std::monostate) SUFFIX NEU(BOOL, bool) SUFFIX NEU(INT32, int32_t)  \
-  SUFFIX NEU(INT64, int64_t)                                                   \
-  SUFFIX NEU(DOUBLE, internal::Double)                                         \
-      SUFFIX NEU(STRING, std::shared_ptr<std::vector<char>>)                   \
-          SUFFIX NEU(ARRAY, std::shared_ptr<std::vector<Value>>)               \
-              SUFFIX NEU(OBJECT, std::shared_ptr<std::vector<Member>>) //
 
 enum Type {
-#define VALUE_NAME(_name, _type) NEU_##_name
-#define SUFFIX ,
-  VALUE(VALUE_NAME)
-#undef SUFFIX
-#undef VALUE_NAME
+  NEU_NULL,
+  NEU_BOOL,
+  NEU_INT32,
+  NEU_INT64,
+  NEU_DOUBLE,
+  NEU_STRING,
+  NEU_ARRAY,
+  NEU_OBJECT,
 };
 
 class Value;
 struct Member;
 
-using Data = std::variant<
-#define VALUE_TYPE(_name, _type) _type
-#define SUFFIX ,
-    VALUE(VALUE_TYPE)
-#undef SUFFIX
-#undef VALUE_TYPE
-    >;
+/**
+ * @brief Characters a string Value borrows instead of copying them, e.g. from
+ * an in-situ parsed buffer. They must outlive every Value referring to them.
+ */
+struct StringRef {
+  explicit StringRef(const std::string_view s) : s_(s) {}
+
+  std::string_view s_;
+};
+
+namespace internal {
+
+/**
+ * @brief Report an index past the end: std::out_of_range, or an abort in
+ * builds without exceptions, as the standard containers' at() does there.
+ * A function of its own so that callers compile either way.
+ */
+[[noreturn]] inline void ThrowOutOfRange() {
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+  throw std::out_of_range("neujson: index out of range");
+#else
+  NEUJSON_ASSERT(false && "neujson: index out of range");
+  std::abort();
+#endif
+}
+
+/**
+ * @brief Reference count of a block shared by the Values copied from one
+ * another, starting at one for the Value which allocates it. Atomic unless
+ * NEUJSON_SINGLE_THREADED_REFCOUNT is set.
+ */
+class RefCount : NonCopyable {
+#if NEUJSON_SINGLE_THREADED_REFCOUNT
+  uint32_t count_ = 1;
+
+public:
+  constexpr RefCount() = default;
+
+  void Retain() { ++count_; }
+  // true once the last reference is gone
+  [[nodiscard]] bool Release() { return --count_ == 0; }
+  [[nodiscard]] uint32_t Count() const { return count_; }
+#else
+  std::atomic<uint32_t> count_{1};
+
+public:
+  constexpr RefCount() = default;
+
+  void Retain() { count_.fetch_add(1, std::memory_order_relaxed); }
+  // true once the last reference is gone
+  [[nodiscard]] bool Release() {
+    return count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+  [[nodiscard]] uint32_t Count() const {
+    return count_.load(std::memory_order_relaxed);
+  }
+#endif // NEUJSON_SINGLE_THREADED_REFCOUNT
+};
+
+/**
+ * @brief Elements of an array or object: a header with the reference count
+ * and the size, followed by room for the first elements in the same
+ * allocation. Growing moves the elements to storage of their own while the
+ * header stays put, so the Values sharing it keep seeing the same elements.
+ * Elements allocated in an Arena grow in it and are never released one by
+ * one.
+ *
+ * Large objects also get a hash index of their keys on their first lookup:
+ * open addressing with linear probing over a power-of-two table, each slot
+ * holding the position of a member, plus one, and the upper half of its key's
+ * hash, so that most probes are decided without touching the members.
+ * Positions stay valid as the members move, and the members keep their
+ * insertion order. Objects which are never searched, as most parsed ones,
+ * never pay for it. The index is published with a compare-exchange, so
+ * concurrent lookups on a shared object are safe; once it exists, adding
+ * members keeps it up to date.
+ */
+template <typename T> class Elements : NonCopyable {
+  static constexpr uint64_t kPositionMask = 0xffffffff;
+
+  RefCount refs_;
+  uint32_t size_ = 0;
+  uint32_t capacity_ = 0;
+  T *data_ = nullptr;
+  Arena *arena_ = nullptr;
+  // objects only, null until looked up with kIndexThreshold members: the
+  // slot count minus one, followed by the slots
+  std::atomic<uint64_t *> index_ = nullptr;
+
+public:
+  // from this many members on, objects find keys through their index
+  static constexpr std::size_t kIndexThreshold = 16;
+
+  // what an array or object without elements reads as
+  static const Elements kEmpty;
+
+  constexpr Elements() = default;
+
+  /**
+   * @brief Allocate a header with room for capacity elements after it.
+   * @param capacity
+   * @param arena where to allocate, the heap if null
+   * @return
+   */
+  static Elements *Create(const std::size_t capacity,
+                          Arena *arena = nullptr) {
+    NEUJSON_ASSERT(capacity <= std::numeric_limits<uint32_t>::max());
+    const std::size_t size = sizeof(Elements) + capacity * sizeof(T);
+    void *memory = arena != nullptr ? arena->Allocate(size, alignof(Elements))
+                                    : ::operator new(size);
+    auto *elements = new (memory) Elements();
+    elements->arena_ = arena;
+    elements->capacity_ = static_cast<uint32_t>(capacity);
+    elements->data_ = capacity == 0 ? nullptr : elements->inlineData();
+    return elements;
+  }
+
+  static void Retain(Elements *elements) { elements->refs_.Retain(); }
+  static uint32_t UseCount(const Elements *elements) {
+    return elements->refs_.Count();
+  }
+
+  static void Release(Elements *elements) {
+    NEUJSON_ASSERT(elements->arena_ == nullptr);
+    if (!elements->refs_.Release()) {
+      return;
+    }
+    std::destroy_n(elements->data_, elements->size_);
+    if (elements->data_ != elements->inlineData()) {
+      ::operator delete(elements->data_);
+    }
+    ::operator delete(elements->index_.load(std::memory_order_relaxed));
+    elements->~Elements();
+    ::operator delete(elements);
+  }
+
+  [[nodiscard]] std::size_t size() const { return size_; }
+  [[nodiscard]] std::size_t capacity() const { return capacity_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+  T *data() { return data_; }
+  [[nodiscard]] const T *data() const { return data_; }
+  T *begin() { return data_; }
+  T *end() { return data_ + size_; }
+  [[nodiscard]] const T *begin() const { return data_; }
+  [[nodiscard]] const T *end() const { return data_ + size_; }
+
+  T &operator[](const std::size_t index) { return data_[index]; }
+  const T &operator[](const std::size_t index) const { return data_[index]; }
+
+  T &at(const std::size_t index) {
+    return const_cast<T &>(std::as_const(*this).at(index));
+  }
+  [[nodiscard]] const T &at(const std::size_t index) const {
+    if (index >= size_) [[unlikely]] {
+      ThrowOutOfRange();
+    }
+    return data_[index];
+  }
+
+  T &back() { return data_[size_ - 1]; }
+  [[nodiscard]] const T &back() const { return data_[size_ - 1]; }
+
+  template <typename... Args> T &emplace_back(Args &&...args) {
+    T &element = size_ == capacity_
+                     ? growAndEmplace(std::forward<Args>(args)...)
+                     : *new (data_ + size_++) T(std::forward<Args>(args)...);
+    if constexpr (std::is_same_v<T, Member>) {
+      if (index_.load(std::memory_order_relaxed) != nullptr) {
+        indexLast();
+      }
+    }
+    return element;
+  }
+
+  /**
+   * @brief Objects only: the member with key, end() if there is none.
+   * @param key
+   * @return
+   */
+  T *find(const std::string_view key) {
+    const uint64_t *index = index_.load(std::memory_order_acquire);
+    if (index == nullptr) {
+      if (size_ < kIndexThreshold) {
+        return std::ranges::find_if(begin(), end(), [key](const T &member) {
+          return sameKey(member.key_.GetStringView(), key);
+        });
+      }
+      index = publishIndex();
+    }
+    const std::size_t hash = std::hash<std::string_view>{}(key);
+    const std::size_t mask = index[0];
+    const uint64_t *slots = index + 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+      const uint64_t slot = slots[i];
+      if (slot == 0) {
+        return end();
+      }
+      if ((slot & ~kPositionMask) == tagOf(hash)) {
+        T &member = data_[(slot & kPositionMask) - 1];
+        if (sameKey(member.key_.GetStringView(), key)) {
+          return &member;
+        }
+      }
+    }
+  }
+
+private:
+  T *inlineData() { return reinterpret_cast<T *>(this + 1); }
+
+  // keys sharing their storage, e.g. interned ones, compare by address
+  static bool sameKey(const std::string_view a, const std::string_view b) {
+    return a.size() == b.size() && (a.data() == b.data() || a == b);
+  }
+
+  static uint64_t tagOf(const std::size_t hash) {
+    return static_cast<uint64_t>(hash) & ~kPositionMask;
+  }
+
+  void insertIndex(uint64_t *index, const uint32_t position) {
+    const std::size_t hash =
+        std::hash<std::string_view>{}(data_[position].key_.GetStringView());
+    const std::size_t mask = index[0];
+    uint64_t *slots = index + 1;
+    std::size_t i = hash & mask;
+    while (slots[i] != 0) {
+      i = (i + 1) & mask;
+    }
+    slots[i] = tagOf(hash) | (position + 1);
+  }
+
+  // an index of all members, at most half full. Arena objects take it from
+  // the shared heap chunks: lookups may run on several threads at once.
+  uint64_t *makeIndex() {
+    const std::size_t slots = std::bit_ceil(std::size_t{size_}) * 4;
+    const std::size_t bytes = (slots + 1) * sizeof(uint64_t);
+    auto *index = static_cast<uint64_t *>(
+        arena_ != nullptr ? arena_->AllocateShared(bytes)
+                          : ::operator new(bytes));
+    index[0] = slots - 1;
+    std::fill_n(index + 1, slots, 0);
+    for (uint32_t position = 0; position < size_; ++position) {
+      insertIndex(index, position);
+    }
+    return index;
+  }
+
+  // the first lookup from kIndexThreshold members on builds the index, the
+  // first one to finish publishes it and the others use that
+  const uint64_t *publishIndex() {
+    uint64_t *index = makeIndex();
+    uint64_t *expected = nullptr;
+    if (index_.compare_exchange_strong(expected, index,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+      return index;
+    }
+    if (arena_ == nullptr) {
+      ::operator delete(index);
+    }
+    return expected;
+  }
+
+  // keep the existing index up to date with the member just added
+  void indexLast() {
+    uint64_t *index = index_.load(std::memory_order_relaxed);
+    if (size_ * 2 <= index[0] + 1) {
+      insertIndex(index, size_ - 1);
+      return;
+    }
+    index_.store(makeIndex(), std::memory_order_release);
+    if (arena_ == nullptr) {
+      ::operator delete(index);
+    }
+  }
+
+  // the new element is made first, args may refer to one of the old ones
+  template <typename... Args> T &growAndEmplace(Args &&...args) {
+    NEUJSON_ASSERT(capacity_ < std::numeric_limits<uint32_t>::max() / 2);
+    const uint32_t capacity = capacity_ < 4 ? 4 : capacity_ * 2;
+    auto *data = static_cast<T *>(
+        arena_ != nullptr ? arena_->Allocate(capacity * sizeof(T), alignof(T))
+                          : ::operator new(capacity * sizeof(T)));
+    T *element = new (data + size_) T(std::forward<Args>(args)...);
+    std::uninitialized_move_n(data_, size_, data);
+    std::destroy_n(data_, size_);
+    if (arena_ == nullptr && data_ != inlineData()) {
+      ::operator delete(data_);
+    }
+    data_ = data;
+    capacity_ = capacity;
+    size_++;
+    return *element;
+  }
+};
+
+template <typename T> constinit const Elements<T> Elements<T>::kEmpty{};
+
+} // namespace internal
 
 class Document;
 
+/**
+ * @brief A JSON value in 16 bytes: 8 bytes of payload, the length of strings
+ * and a byte with the type and flags. Numbers and booleans live in the
+ * payload, and so do strings of up to 14 characters, which take the length's
+ * place too; longer strings, arrays and objects point to their characters or
+ * elements.
+ * Copies share what they point to through a reference count, which only the
+ * Value owning the storage touches; reading never does.
+ *
+ * Storage allocated in an Arena is not counted: it lives as long as the arena,
+ * copies included, and is released with it. Values added to an arena-backed
+ * array or object should be allocated in the same arena, or borrow their
+ * strings, since nothing destroys the elements of arena storage.
+ */
 class Value {
 public:
-  using MemberIterator = std::vector<Member>::iterator;
-  using ConstMemberIterator = std::vector<Member>::const_iterator;
-
-#define VALUE_TYPE(_name, _type) using NEU_##_name##_TYPE = _type;
-#define SUFFIX
-  VALUE(VALUE_TYPE)
-#undef SUFFIX
-#undef VALUE_TYPE
+  using Array = internal::Elements<Value>;
+  using Object = internal::Elements<Member>;
+  using MemberIterator = Member *;
+  using ConstMemberIterator = const Member *;
 
 private:
   friend class Document;
 
-  using String = std::vector<char>;
-  using Array = std::vector<Value>;
-  using Object = std::vector<Member>;
-
-  Type type_;
-  Data data_;
+  // the low bits of flags_ hold the type
+  static constexpr uint8_t kTypeMask = 0x07;
+  // the payload points to reference counted storage
+  static constexpr uint8_t kRefCounted = 0x08;
+  // the characters of a string are stored in the Value itself
+  static constexpr uint8_t kShortString = 0x10;
+  // how many characters fit, the byte after them holds their number
+  static constexpr std::size_t kShortLength = 14;
+
+  union {
+    int64_t i64_ = 0;
+    int32_t i32_;
+    bool b_;
+    internal::Double d_;
+    const char *chars_;
+    Array *array_;
+    Object *object_;
+  };
+  uint32_t length_ = 0;
+  // with the payload and length_, room for the characters of short strings
+  char tail_[3] = {};
+  uint8_t flags_ = NEU_NULL;
 
 public:
-  explicit Value(Type type = NEU_NULL);
-  explicit Value(bool b) : type_(NEU_BOOL), data_(b) {};
-  explicit Value(int32_t i32) : type_(NEU_INT32), data_(i32) {};
-  explicit Value(int64_t i64) : type_(NEU_INT64), data_(i64) {};
-  explicit Value(double d) : type_(NEU_DOUBLE), data_(internal::Double(d)) {};
-  explicit Value(internal::Double d) : type_(NEU_DOUBLE), data_(d) {};
-  explicit Value(const char *s)
-      : type_(NEU_STRING), data_(std::make_shared<String>(s, s + strlen(s))) {};
-  explicit Value(std::string_view s)
-      : type_(NEU_STRING),
-        data_(std::make_shared<String>(s.begin(), s.end())) {};
+  explicit Value(const Type type = NEU_NULL)
+      : flags_(static_cast<uint8_t>(type)) {}
+  Value(Type type, Arena &arena);
+  explicit Value(bool b) : flags_(NEU_BOOL) { b_ = b; }
+  explicit Value(int32_t i32) : flags_(NEU_INT32) { i32_ = i32; }
+  explicit Value(int64_t i64) : i64_(i64), flags_(NEU_INT64) {}
+  explicit Value(double d) : d_(d), flags_(NEU_DOUBLE) {}
+  explicit Value(internal::Double d) : d_(d), flags_(NEU_DOUBLE) {}
+  explicit Value(const char *s) : Value(std::string_view(s)) {}
+  explicit Value(std::string_view s);
   Value(const char *s, const std::size_t len)
-      : Value(std::string_view(s, len)) {};
-  Value(const Value &val) = default;
-  Value(Value &&val) noexcept
-      : type_(val.type_), data_(std::move(val.data_)) {};
-  ~Value() = default;
+      : Value(std::string_view(s, len)) {}
+  Value(std::string_view s, Arena &arena);
+  explicit Value(const StringRef s)
+      : chars_(s.s_.data()), length_(static_cast<uint32_t>(s.s_.size())),
+        flags_(NEU_STRING) {
+    NEUJSON_ASSERT(s.s_.size() <= std::numeric_limits<uint32_t>::max());
+  }
+  Value(const Value &val) noexcept {
+    copyBits(val);
+    retain();
+  }
+  Value(Value &&val) noexcept {
+    copyBits(val);
+    val.flags_ = NEU_NULL;
+  }
+  ~Value() { release(); }
 
-  [[nodiscard]] Type GetType() const { return type_; };
+  [[nodiscard]] Type GetType() const {
+    return static_cast<Type>(flags_ & kTypeMask);
+  }
   [[nodiscard]] std::size_t GetSize() const;
 
-  [[nodiscard]] bool IsNull() const { return type_ == NEU_NULL; }
-  [[nodiscard]] bool IsBool() const { return type_ == NEU_BOOL; }
-  [[nodiscard]] bool IsInt32() const { return type_ == NEU_INT32; }
+  /**
+   * @brief How many Values share this one's string or elements, for
+   * diagnostics: only copying, assigning and destroying change it. 0 if
+   * nothing is counted: scalars, short strings, empty containers, borrowed
+   * strings and arena storage.
+   * @return
+   */
+  [[nodiscard]] std::size_t UseCount() const;
+
+  [[nodiscard]] bool IsNull() const { return GetType() == NEU_NULL; }
+  [[nodiscard]] bool IsBool() const { return GetType() == NEU_BOOL; }
+  [[nodiscard]] bool IsInt32() const { return GetType() == NEU_INT32; }
   [[nodiscard]] bool IsInt64() const {
-    return type_ == NEU_INT64 || type_ == NEU_INT32;
+    return GetType() == NEU_INT64 || GetType() == NEU_INT32;
   }
-  [[nodiscard]] bool IsDouble() const { return type_ == NEU_DOUBLE; }
-  [[nodiscard]] bool IsString() const { return type_ == NEU_STRING; }
-  [[nodiscard]] bool IsArray() const { return type_ == NEU_ARRAY; }
-  [[nodiscard]] bool IsObject() const { return type_ == NEU_OBJECT; }
+  [[nodiscard]] bool IsDouble() const { return GetType() == NEU_DOUBLE; }
+  [[nodiscard]] bool IsString() const { return GetType() == NEU_STRING; }
+  [[nodiscard]] bool IsArray() const { return GetType() == NEU_ARRAY; }
+  [[nodiscard]] bool IsObject() const { return GetType() == NEU_OBJECT; }
 
   // getter
   //@formatter:off
   [[nodiscard]] bool GetBool() const {
-    NEUJSON_ASSERT(type_ == NEU_BOOL);
-    return std::get<NEU_BOOL_TYPE>(data_);
+    NEUJSON_ASSERT(GetType() == NEU_BOOL);
+    return b_;
   }
   [[nodiscard]] int32_t GetInt32() const {
-    NEUJSON_ASSERT(type_ == NEU_INT32);
-    return std::get<NEU_INT32_TYPE>(data_);
+    NEUJSON_ASSERT(GetType() == NEU_INT32);
+    return i32_;
   }
 
   [[nodiscard]] int64_t GetInt64() const {
-    NEUJSON_ASSERT(type_ == NEU_INT64 || type_ == NEU_INT32);
-    return type_ == NEU_INT64 ? std::get<NEU_INT64_TYPE>(data_)
-                              : std::get<NEU_INT32_TYPE>(data_);
+    NEUJSON_ASSERT(GetType() == NEU_INT64 || GetType() == NEU_INT32);
+    return GetType() == NEU_INT64 ? i64_ : i32_;
   }
 
   [[nodiscard]] double GetDouble() const {
-    NEUJSON_ASSERT(type_ == NEU_DOUBLE);
-    return std::get<NEU_DOUBLE_TYPE>(data_).Value();
+    NEUJSON_ASSERT(GetType() == NEU_DOUBLE);
+    return d_.Value();
   }
 
+  // short strings live in the Value, moving it invalidates their views
   [[nodiscard]] std::string_view GetStringView() const {
-    NEUJSON_ASSERT(type_ == NEU_STRING);
-    auto s_ptr = std::get<NEU_STRING_TYPE>(data_);
-    return {s_ptr->data(), s_ptr->size()};
+    NEUJSON_ASSERT(GetType() == NEU_STRING);
+    if ((flags_ & kShortString) != 0) {
+      return {shortChars(), static_cast<uint8_t>(tail_[2])};
+    }
+    return {chars_, length_};
   }
 
   [[nodiscard]] std::string GetString() const {
     return std::string(GetStringView());
   }
-  [[nodiscard]] const auto &GetArray() const {
-    NEUJSON_ASSERT(type_ == NEU_ARRAY);
-    return std::get<NEU_ARRAY_TYPE>(data_);
+  [[nodiscard]] const Array *GetArray() const {
+    NEUJSON_ASSERT(GetType() == NEU_ARRAY);
+    return array_ != nullptr ? array_ : &Array::kEmpty;
   }
-  [[nodiscard]] const auto &GetObject() const {
-    NEUJSON_ASSERT(type_ == NEU_OBJECT);
-    return std::get<NEU_OBJECT_TYPE>(data_);
+  [[nodiscard]] const Object *GetObject() const {
+    NEUJSON_ASSERT(GetType() == NEU_OBJECT);
+    return object_ != nullptr ? object_ : &Object::kEmpty;
   }
   //@formatter:on
 
@@ -244,8 +589,8 @@ public:
   }
 
   Value &SetString(std::string_view _s) {
-    this->~Value();
-    return *new (this) Value(_s);
+    // _s may be this very string, copy it before letting go
+    return *this = Value(_s);
   }
 
   Value &SetArray() {
@@ -281,9 +626,30 @@ public:
 
   template <required::handler::HasAllRequiredFunctions Handler>
   bool WriteTo(Handler &handler) const;
+
+private:
+  // all 16 bytes, the characters of a short string included
+  void copyBits(const Value &val) {
+    std::memcpy(static_cast<void *>(this), static_cast<const void *>(&val),
+                sizeof(Value));
+  }
+
+  [[nodiscard]] const char *shortChars() const {
+    return reinterpret_cast<const char *>(this);
+  }
+  // store s in place if it is short enough
+  bool setShortString(std::string_view s);
+
+  // the count in front of the characters of an owned string
+  [[nodiscard]] internal::RefCount *stringRefs() const {
+    return reinterpret_cast<internal::RefCount *>(const_cast<char *>(chars_)) -
+           1;
+  }
+  void retain() const;
+  void release();
 };
 
-#undef VALUE
+static_assert(sizeof(Value) == 16, "Value is meant to take 16 bytes");
 
 struct Member {
   Member(Value &&key, Value &&value)
@@ -295,34 +661,120 @@ struct Member {
   Value value_;
 };
 
-inline Value::Value(Type type) : type_(type) {
-  switch (type_) {
-  case NEU_NULL:
-  case NEU_BOOL:
-  case NEU_INT32:
-  case NEU_INT64:
-  case NEU_DOUBLE:
-    break;
+inline bool Value::setShortString(const std::string_view s) {
+  if (s.size() > kShortLength) {
+    return false;
+  }
+  std::memcpy(reinterpret_cast<char *>(this), s.data(), s.size());
+  tail_[2] = static_cast<char>(s.size());
+  flags_ = NEU_STRING | kShortString;
+  return true;
+}
+
+inline Value::Value(const std::string_view s) : flags_(NEU_STRING) {
+  if (setShortString(s)) {
+    return;
+  }
+  NEUJSON_ASSERT(s.size() <= std::numeric_limits<uint32_t>::max());
+  length_ = static_cast<uint32_t>(s.size());
+  // the characters follow their reference count in one allocation
+  void *memory = ::operator new(sizeof(internal::RefCount) + s.size());
+  auto *refs = new (memory) internal::RefCount();
+  auto *chars = reinterpret_cast<char *>(refs + 1);
+  std::memcpy(chars, s.data(), s.size());
+  chars_ = chars;
+  flags_ |= kRefCounted;
+}
+
+inline Value::Value(const Type type, Arena &arena)
+    : flags_(static_cast<uint8_t>(type)) {
+  // containers take their header from the arena now, so they grow in it
+  if (type == NEU_ARRAY) {
+    array_ = Array::Create(0, &arena);
+  } else if (type == NEU_OBJECT) {
+    object_ = Object::Create(0, &arena);
+  } else if (type == NEU_STRING) {
+    flags_ |= kShortString;
+  }
+}
+
+inline Value::Value(const std::string_view s, Arena &arena)
+    : flags_(NEU_STRING) {
+  if (setShortString(s)) {
+    return;
+  }
+  NEUJSON_ASSERT(s.size() <= std::numeric_limits<uint32_t>::max());
+  length_ = static_cast<uint32_t>(s.size());
+  auto *chars = static_cast<char *>(arena.Allocate(s.size(), 1));
+  std::memcpy(chars, s.data(), s.size());
+  chars_ = chars;
+}
+
+inline void Value::retain() const {
+  if ((flags_ & kRefCounted) == 0) {
+    return;
+  }
+  switch (GetType()) {
   case NEU_STRING:
-    data_ = std::make_shared<String>();
+    stringRefs()->Retain();
+    break;
+  case NEU_ARRAY:
+    Array::Retain(array_);
+    break;
+  case NEU_OBJECT:
+    Object::Retain(object_);
+    break;
+  default:
+    break;
+  }
+}
+
+inline void Value::release() {
+  if ((flags_ & kRefCounted) == 0) {
+    return;
+  }
+  switch (GetType()) {
+  case NEU_STRING: {
+    auto *refs = stringRefs();
+    if (refs->Release()) {
+      refs->~RefCount();
+      ::operator delete(refs);
+    }
     break;
+  }
   case NEU_ARRAY:
-    data_ = std::make_shared<Array>();
+    Array::Release(array_);
     break;
   case NEU_OBJECT:
-    data_ = std::make_shared<Object>();
+    Object::Release(object_);
     break;
   default:
-    NEUJSON_ASSERT(false && "bad value GetType");
+    break;
+  }
+}
+
+inline std::size_t Value::UseCount() const {
+  if ((flags_ & kRefCounted) == 0) {
+    return 0;
+  }
+  switch (GetType()) {
+  case NEU_STRING:
+    return stringRefs()->Count();
+  case NEU_ARRAY:
+    return Array::UseCount(array_);
+  case NEU_OBJECT:
+    return Object::UseCount(object_);
+  default:
+    return 0;
   }
 }
 
 inline std::size_t Value::GetSize() const {
-  switch (type_) {
+  switch (GetType()) {
   case NEU_ARRAY:
-    return std::get<NEU_STRING_TYPE>(data_)->size();
+    return GetArray()->size();
   case NEU_OBJECT:
-    return std::get<NEU_OBJECT_TYPE>(data_)->size();
+    return GetObject()->size();
   default:
     return 1;
   }
@@ -330,33 +782,33 @@ inline std::size_t Value::GetSize() const {
 
 inline Value &Value::operator=(const Value &val) {
   NEUJSON_ASSERT(this != &val);
-  type_ = val.type_;
-  data_ = val.data_;
+  val.retain();
+  release();
+  copyBits(val);
   return *this;
 }
 
 inline Value &Value::operator=(Value &&val) noexcept {
   NEUJSON_ASSERT(this != &val);
-  type_ = val.type_;
-  data_ = std::move(val.data_);
-  val.type_ = NEU_NULL;
+  release();
+  copyBits(val);
+  val.flags_ = NEU_NULL;
   return *this;
 }
 
 inline Value &Value::operator[](const std::size_t index) {
-  NEUJSON_ASSERT(type_ == NEU_ARRAY);
-  return std::get<NEU_ARRAY_TYPE>(data_)->at(index);
+  return const_cast<Value &>(std::as_const(*this)[index]);
 }
 
 inline const Value &Value::operator[](const std::size_t index) const {
-  NEUJSON_ASSERT(type_ == NEU_ARRAY);
-  return std::get<NEU_ARRAY_TYPE>(data_)->at(index);
+  NEUJSON_ASSERT(GetType() == NEU_ARRAY);
+  return GetArray()->at(index);
 }
 
 inline Value &Value::operator[](const std::string_view key) {
-  NEUJSON_ASSERT(type_ == NEU_OBJECT);
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
   auto it = FindMember(key);
-  if (it != std::get<NEU_OBJECT_TYPE>(data_)->end()) {
+  if (it != MemberEnd()) {
     return it->value_;
   }
 
@@ -366,48 +818,47 @@ inline Value &Value::operator[](const std::string_view key) {
 }
 
 inline const Value &Value::operator[](const std::string_view key) const {
-  NEUJSON_ASSERT(type_ == NEU_OBJECT);
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
   return const_cast<Value &>(*this)[key];
 }
 
 template <typename T> Value &Value::AddValue(T &&value) {
-  NEUJSON_ASSERT(type_ == NEU_ARRAY);
-  auto a_ptr = std::get<NEU_ARRAY_TYPE>(data_);
-  a_ptr->emplace_back(std::forward<T>(value));
-  return a_ptr->back();
+  NEUJSON_ASSERT(GetType() == NEU_ARRAY);
+  if (array_ == nullptr) {
+    array_ = Array::Create(0);
+    flags_ |= kRefCounted;
+  }
+  return array_->emplace_back(std::forward<T>(value));
 }
 
 inline Value::MemberIterator Value::MemberBegin() {
-  NEUJSON_ASSERT(type_ == NEU_OBJECT);
-  return std::get<NEU_OBJECT_TYPE>(data_)->begin();
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
+  return object_ != nullptr ? object_->begin() : nullptr;
 }
 
 inline Value::MemberIterator Value::MemberEnd() {
-  NEUJSON_ASSERT(type_ == NEU_OBJECT);
-  return std::get<NEU_OBJECT_TYPE>(data_)->end();
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
+  return object_ != nullptr ? object_->end() : nullptr;
 }
 
 inline Value::MemberIterator Value::FindMember(const std::string_view key) {
-  NEUJSON_ASSERT(type_ == NEU_OBJECT);
-  return std::ranges::find_if(*std::get<NEU_OBJECT_TYPE>(data_),
-                              [key](const Member &_m) -> bool {
-                                return _m.key_.GetStringView() == key;
-                              });
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
+  return object_ != nullptr ? object_->find(key) : nullptr;
 }
 
 inline Value::ConstMemberIterator Value::MemberBegin() const {
-  NEUJSON_ASSERT(type_ == NEU_OBJECT);
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
   return const_cast<Value &>(*this).MemberBegin();
 }
 
 inline Value::ConstMemberIterator Value::MemberEnd() const {
-  NEUJSON_ASSERT(type_ == NEU_OBJECT);
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
   return const_cast<Value &>(*this).MemberEnd();
 }
 
 inline Value::ConstMemberIterator
 Value::FindMember(const std::string_view key) const {
-  NEUJSON_ASSERT(type_ == NEU_OBJECT);
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
   return const_cast<Value &>(*this).FindMember(key);
 }
 
@@ -416,12 +867,14 @@ template <typename T> Value &Value::AddMember(const char *key, T &&value) {
 }
 
 inline Value &Value::AddMember(Value &&key, Value &&value) {
-  NEUJSON_ASSERT(type_ == NEU_OBJECT);
-  NEUJSON_ASSERT(key.type_ == NEU_STRING);
+  NEUJSON_ASSERT(GetType() == NEU_OBJECT);
+  NEUJSON_ASSERT(key.GetType() == NEU_STRING);
   NEUJSON_ASSERT(FindMember(key.GetStringView()) == MemberEnd());
-  auto o_ptr = std::get<NEU_OBJECT_TYPE>(data_);
-  o_ptr->emplace_back(std::move(key), std::move(value));
-  return o_ptr->back().value_;
+  if (object_ == nullptr) {
+    object_ = Object::Create(0);
+    flags_ |= kRefCounted;
+  }
+  return object_->emplace_back(std::move(key), std::move(value)).value_;
 }
 
 #define CALL_HANDLER(_expr)                                                    \
@@ -433,21 +886,21 @@ inline Value &Value::AddMember(Value &&key, Value &&value) {
 
 template <required::handler::HasAllRequiredFunctions Handler>
 bool Value::WriteTo(Handler &handler) const {
-  switch (type_) {
+  switch (GetType()) {
   case NEU_NULL:
     CALL_HANDLER(handler.Null());
     break;
   case NEU_BOOL:
-    CALL_HANDLER(handler.Bool(std::get<NEU_BOOL_TYPE>(data_)));
+    CALL_HANDLER(handler.Bool(b_));
     break;
   case NEU_INT32:
-    CALL_HANDLER(handler.Int32(std::get<NEU_INT32_TYPE>(data_)));
+    CALL_HANDLER(handler.Int32(i32_));
     break;
   case NEU_INT64:
-    CALL_HANDLER(handler.Int64(std::get<NEU_INT64_TYPE>(data_)));
+    CALL_HANDLER(handler.Int64(i64_));
     break;
   case NEU_DOUBLE:
-    CALL_HANDLER(handler.Double(std::get<NEU_DOUBLE_TYPE>(data_)));
+    CALL_HANDLER(handler.Double(d_));
     break;
   case NEU_STRING:
     CALL_HANDLER(handler.String(GetStringView()));
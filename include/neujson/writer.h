@@ -13,6 +13,7 @@
 
 #include "internal/ieee754.h"
 #include "internal/itoa.h"
+#include "internal/simd.h"
 #include "neujson.h"
 #include "non_copyable.h"
 #include "value.h"
@@ -246,8 +247,19 @@ bool Writer<WriteStream>::WriteDouble(const internal::Double d) {
 template <required::write_stream::HasAllRequiredFunctions WriteStream>
 bool Writer<WriteStream>::WriteString(const std::string_view str) {
   os_.put('"');
-  for (auto c : str) {
-    switch (const auto u = static_cast<unsigned char>(c); u) {
+  const char *p = str.data();
+  const char *end = p + str.size();
+  while (true) {
+    // write the run which needs no escaping at once
+    const char *run = p;
+    p = internal::ScanString(p, end);
+    if (p != run) {
+      os_.puts(run, static_cast<std::size_t>(p - run));
+    }
+    if (p == end) {
+      break;
+    }
+    switch (const auto u = static_cast<unsigned char>(*p++); u) {
     case '\"':
       os_.puts("\\\"", 2);
       break;
@@ -269,14 +281,12 @@ bool Writer<WriteStream>::WriteString(const std::string_view str) {
     case '\\':
       os_.puts("\\\\", 2);
       break;
-    default:
-      if (u < 0x20) {
-        char buf[7];
-        snprintf(buf, 7, "\\u%04X", u);
-        os_.puts(buf, 6);
-      } else {
-        os_.put(c);
-      }
+    default: {
+      NEUJSON_ASSERT(u < 0x20);
+      char buf[7];
+      snprintf(buf, 7, "\\u%04X", u);
+      os_.puts(buf, 6);
+    }
     }
   }
   os_.put('"');
@@ -0,0 +1,118 @@
+#include <cstddef>
+#include <cstdlib>
+
+#include <new>
+#include <sstream>
+#include <string>
+
+#include "neujson/document.h"
+#include "neujson/istream_wrapper.h"
+#include "neujson/string_read_stream.h"
+#include "neujson/structural_reader.h"
+#include "neujson/tape_document.h"
+
+#include "gtest/gtest.h"
+
+// every heap allocation of this program goes through here
+namespace {
+std::size_t allocations = 0;
+} // namespace
+
+void *operator new(const std::size_t size) {
+  ++allocations;
+  if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+// gcc pairs the operator new of inlined callers with the free below
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+// strings with escapes past the inline capacity of std::string, keys too
+std::string EscapedJson() {
+  std::string json = "[";
+  for (int i = 0; i < 100; ++i) {
+    json += R"({"an escaped\tkey, long enough":"an escaped\nstring, )"
+            R"(long enough to leave the inline capacity behind"},)";
+  }
+  json += R"("ééééééééé"])";
+  return json;
+}
+
+} // namespace
+
+TEST(allocation, document) {
+  const std::string json = EscapedJson();
+  neujson::Document doc(nullptr, 0);
+  // the first parse grows the arena and the scratch space, later ones reuse
+  // them
+  EXPECT_EQ(neujson::error::OK, doc.Parse(json));
+  const std::size_t before = allocations;
+  bool ok = true;
+  for (int i = 0; i < 10; ++i) {
+    doc.Clear();
+    ok = ok && doc.Parse(json) == neujson::error::OK;
+  }
+  EXPECT_EQ(before, allocations);
+  EXPECT_TRUE(ok);
+
+  // streams unescape every string into the scratch space
+  std::stringstream iss{json};
+  char buffer[256];
+  neujson::Document stream_doc(nullptr, 0);
+  const auto parse_stream = [&] {
+    iss.clear();
+    iss.seekg(0);
+    neujson::IStreamWrapper is(iss, buffer);
+    stream_doc.Clear();
+    return stream_doc.ParseStream(is);
+  };
+  EXPECT_EQ(neujson::error::OK, parse_stream());
+  const std::size_t stream_before = allocations;
+  for (int i = 0; i < 10; ++i) {
+    ok = ok && parse_stream() == neujson::error::OK;
+  }
+  EXPECT_EQ(stream_before, allocations);
+  EXPECT_TRUE(ok);
+}
+
+TEST(allocation, tape_document) {
+  const std::string json = EscapedJson();
+  neujson::TapeDocument doc;
+  EXPECT_EQ(neujson::error::OK, doc.Parse(json));
+  const std::size_t before = allocations;
+  bool ok = true;
+  for (int i = 0; i < 10; ++i) {
+    ok = ok && doc.Parse(json) == neujson::error::OK;
+  }
+  EXPECT_EQ(before, allocations);
+  EXPECT_TRUE(ok);
+}
+
+TEST(allocation, structural_reader) {
+  const std::string json = EscapedJson();
+  neujson::StructuralReader reader;
+  neujson::Document doc(nullptr, 0);
+  neujson::StringReadStream first(json);
+  EXPECT_EQ(neujson::error::OK, reader.Parse(first, doc));
+  const std::size_t before = allocations;
+  bool ok = true;
+  for (int i = 0; i < 10; ++i) {
+    neujson::StringReadStream read_stream(json);
+    doc.Clear();
+    ok = ok && reader.Parse(read_stream, doc) == neujson::error::OK;
+  }
+  EXPECT_EQ(before, allocations);
+  EXPECT_TRUE(ok);
+}
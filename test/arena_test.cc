@@ -0,0 +1,171 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "neujson/arena.h"
+#include "neujson/document.h"
+#include "neujson/string_write_stream.h"
+#include "neujson/writer.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+std::string Write(const neujson::Value &value) {
+  neujson::StringWriteStream os;
+  neujson::Writer writer(os);
+  value.WriteTo(writer);
+  return std::string(os.get());
+}
+
+} // namespace
+
+TEST(arena, allocate) {
+  neujson::Arena arena(256);
+  std::vector<char *> blocks;
+  for (std::size_t i = 0; i < 1000; ++i) {
+    const std::size_t align = std::size_t{1} << (i % 5);
+    const std::size_t size = i % 7 == 0 ? 1000 : i % 50 + 1;
+    auto *block = static_cast<char *>(arena.Allocate(size, align));
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(block) % align);
+    // blocks do not overlap, which the sanitizers check as well
+    std::fill_n(block, size, static_cast<char>(i));
+    blocks.push_back(block);
+  }
+  for (std::size_t i = 0; i < blocks.size(); ++i) {
+    EXPECT_EQ(static_cast<char>(i), blocks[i][0]);
+  }
+}
+
+TEST(arena, buffer) {
+  alignas(std::max_align_t) char buffer[1024];
+  neujson::Arena arena(buffer, sizeof(buffer));
+  auto *first = static_cast<char *>(arena.Allocate(100));
+  EXPECT_EQ(buffer, first);
+  auto *second = static_cast<char *>(arena.Allocate(100, 1));
+  EXPECT_EQ(buffer + 100, second);
+  // past the buffer, on to heap chunks
+  auto *third = static_cast<char *>(arena.Allocate(1000));
+  EXPECT_TRUE(third < buffer || third >= buffer + sizeof(buffer));
+}
+
+TEST(arena, allocate_shared) {
+  neujson::Arena arena;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&arena, t] {
+      for (std::size_t i = 0; i < 100; ++i) {
+        auto *block = static_cast<char *>(arena.AllocateShared(i + 1));
+        EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(block) %
+                          alignof(std::max_align_t));
+        std::fill_n(block, i + 1, static_cast<char>(t));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  // released here, the rest with the arena
+  arena.Clear();
+  std::fill_n(static_cast<char *>(arena.AllocateShared(10)), 10, 'x');
+}
+
+TEST(arena, document) {
+  constexpr std::string_view kJson =
+      R"({"a":[1,-2.5,"long enough to be a heap string",true,null],)"
+      R"("b":{"c":{},"d":[]},"e":"","f":[[1,2,3,4,5,6,7,8,9,10]]})";
+
+  neujson::Document heap;
+  EXPECT_EQ(neujson::error::OK, heap.Parse(kJson));
+
+  // an arena of the document's own
+  neujson::Document own(nullptr, 0);
+  EXPECT_EQ(neujson::error::OK, own.Parse(kJson));
+  EXPECT_EQ(Write(heap), Write(own));
+
+  // an arena starting with a buffer, shared with a second document
+  alignas(std::max_align_t) char buffer[4096];
+  neujson::Arena arena(buffer, sizeof(buffer));
+  neujson::Document doc(arena);
+  EXPECT_EQ(neujson::error::OK, doc.Parse(kJson));
+  EXPECT_EQ(Write(heap), Write(doc));
+  const auto in_buffer = [&buffer](const void *p) {
+    return p >= buffer && p < buffer + sizeof(buffer);
+  };
+  EXPECT_TRUE(in_buffer(doc["a"][2].GetStringView().data()));
+  EXPECT_TRUE(in_buffer(doc.GetObject()));
+
+  neujson::Document next(arena);
+  EXPECT_EQ(neujson::error::OK, next.Parse(kJson));
+  EXPECT_EQ(Write(heap), Write(next));
+
+  // arena containers grow in the arena after the parse, and so may their
+  // copies, which share them
+  neujson::Value copy = doc["f"][0];
+  doc["f"][0].AddValue(neujson::Value(11));
+  EXPECT_EQ(11UL, copy.GetSize());
+  copy.AddValue(neujson::Value("x", arena));
+  EXPECT_EQ("x", doc["f"][0][11].GetStringView());
+
+  // in-situ strings stay in the input, containers go to the arena
+  std::string insitu_json(kJson);
+  neujson::Document insitu(arena);
+  EXPECT_EQ(neujson::error::OK,
+            insitu.ParseInsitu(insitu_json.data(), insitu_json.size()));
+  EXPECT_EQ(Write(heap), Write(insitu));
+}
+
+TEST(arena, clear) {
+  alignas(std::max_align_t) char buffer[256];
+  neujson::Arena arena(buffer, sizeof(buffer), 1024);
+  std::vector<void *> blocks;
+  for (std::size_t i = 0; i < 100; ++i) {
+    blocks.push_back(arena.Allocate(i % 3 == 0 ? 200 : 100));
+  }
+  // the same requests get the same memory, nothing is allocated
+  arena.Clear();
+  EXPECT_EQ(buffer, blocks[0]);
+  for (std::size_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(blocks[i], arena.Allocate(i % 3 == 0 ? 200 : 100));
+  }
+}
+
+TEST(arena, reuse_document) {
+  constexpr std::string_view kJson =
+      R"({"a":[1,-2.5,"long enough to be a heap string",true,null],)"
+      R"("b":{"c":{},"d":[]},"e":"","f":[[1,2,3,4,5,6,7,8,9,10]]})";
+
+  // parsing again replaces the tree
+  neujson::Document heap;
+  EXPECT_EQ(neujson::error::OK, heap.Parse(R"({"old":[]})"));
+  EXPECT_EQ(neujson::error::OK, heap.Parse(kJson));
+  const std::string expected = Write(heap);
+  EXPECT_NE(heap.MemberEnd(), heap.FindMember("a"));
+  EXPECT_EQ(heap.MemberEnd(), heap.FindMember("old"));
+
+  // and a cleared arena document builds it in the same memory
+  neujson::Document doc(nullptr, 0);
+  EXPECT_EQ(neujson::error::OK, doc.Parse(kJson));
+  const auto *object = doc.GetObject();
+  const char *string = doc["a"][2].GetStringView().data();
+  for (int i = 0; i < 3; ++i) {
+    doc.Clear();
+    EXPECT_TRUE(doc.IsNull());
+    EXPECT_EQ(neujson::error::OK, doc.Parse(kJson));
+    EXPECT_EQ(expected, Write(doc));
+    EXPECT_EQ(object, doc.GetObject());
+    EXPECT_EQ(string, doc["a"][2].GetStringView().data());
+  }
+
+  // unless a copy of the document still uses the arena
+  const neujson::Document copy = doc;
+  doc.Clear();
+  EXPECT_EQ(neujson::error::OK, doc.Parse(R"({"other":[1,2,3]})"));
+  EXPECT_EQ(expected, Write(copy));
+  EXPECT_EQ(3UL, doc["other"].GetSize());
+}
@@ -15,3 +15,11 @@ TEST(clzll, normal) {
   EXPECT_EQ(clzll(0x0000000080000001UL), 32U);
   EXPECT_EQ(clzll(0x8000000000000001UL), 0U);
 }
+
+TEST(ctzll, normal) {
+  EXPECT_EQ(ctzll(1), 0U);
+  EXPECT_EQ(ctzll(2), 1U);
+  EXPECT_EQ(ctzll(12), 2U);
+  EXPECT_EQ(ctzll(0x0000000100000000UL), 32U);
+  EXPECT_EQ(ctzll(0x8000000000000000UL), 63U);
+}
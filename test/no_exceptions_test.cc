@@ -0,0 +1,50 @@
+// built with -fno-exceptions where the compiler has it, see CMakeLists.txt
+
+#include <string_view>
+
+#include "neujson/document.h"
+#include "neujson/reader.h"
+#include "neujson/string_write_stream.h"
+#include "neujson/tape_document.h"
+#include "neujson/value.h"
+#include "neujson/writer.h"
+
+#include "gtest/gtest.h"
+
+TEST(no_exceptions, document) {
+  constexpr std::string_view kJson = R"({"a":[1,"two",3.5],"b":null})";
+  neujson::Document doc;
+  ASSERT_EQ(neujson::error::OK, doc.Parse(kJson));
+  EXPECT_EQ(1, doc["a"][0].GetInt32());
+  EXPECT_EQ("two", doc["a"][1].GetStringView());
+
+  neujson::StringWriteStream os;
+  neujson::Writer writer(os);
+  doc.WriteTo(writer);
+  EXPECT_EQ(kJson, os.get());
+
+  // errors come back as values
+  neujson::Document bad;
+  EXPECT_EQ(neujson::error::MISS_COMMA_OR_SQUARE_BRACKET, bad.Parse("[1 2]"));
+}
+
+TEST(no_exceptions, tape_document) {
+  neujson::TapeDocument doc;
+  ASSERT_EQ(neujson::error::OK, doc.Parse(R"({"a":[1,"two"]})"));
+  EXPECT_EQ("two", doc.GetRoot()["a"][1].GetStringView());
+}
+
+TEST(no_exceptions, out_of_range) {
+  neujson::Document doc;
+  ASSERT_EQ(neujson::error::OK, doc.Parse("[1]"));
+  neujson::TapeDocument tape;
+  ASSERT_EQ(neujson::error::OK, tape.Parse("[1]"));
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+  EXPECT_THROW((void)doc[1], std::out_of_range);
+  EXPECT_THROW((void)tape.GetRoot()[1], std::out_of_range);
+#else
+  // what std::vector::at() does without exceptions
+  EXPECT_DEATH((void)doc[1], "");
+  EXPECT_DEATH((void)tape.GetRoot()[1], "");
+#endif
+}
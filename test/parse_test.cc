@@ -4,14 +4,18 @@
 
 #include <cstdint>
 
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include "neujson/document.h"
 #include "neujson/exception.h"
 #include "neujson/internal/ieee754.h"
+#include "neujson/istream_wrapper.h"
 #include "neujson/non_copyable.h"
+#include "neujson/padded_read_stream.h"
 #include "neujson/reader.h"
 #include "neujson/string_read_stream.h"
 #include "neujson/string_write_stream.h"
@@ -174,6 +178,36 @@ TEST(parse, int64) {
   TEST_INT64(-12345678901234, "-12345678901234");
   TEST_INT64(INT64_MAX, "9223372036854775807");
   TEST_INT64(INT64_MIN, "-9223372036854775808");
+  TEST_INT64(2147483648LL, "2147483648");
+  TEST_INT64(-2147483649LL, "-2147483649");
+  TEST_INT64(1717171717171717LL, "1717171717171717");
+  TEST_INT64(-100000000000000000LL, "-100000000000000000");
+}
+
+TEST(parse, integer_stream) {
+  // every digit count on both the contiguous (SWAR) and the generic path
+  for (int64_t i = 1;; i *= 10) {
+    for (const int64_t v : {i, i * 7 + 3, -i, -(i * 9 + 1)}) {
+      const std::string json = std::to_string(v);
+
+      neujson::StringReadStream read_stream(json);
+      TestHandler contiguous;
+      EXPECT_EQ(neujson::error::ParseError::OK,
+                neujson::Reader::Parse(read_stream, contiguous));
+      EXPECT_EQ(v, contiguous.value().GetInt64());
+
+      std::stringstream iss{json};
+      neujson::IStreamWrapper is(iss);
+      TestHandler generic;
+      EXPECT_EQ(neujson::error::ParseError::OK,
+                neujson::Reader::Parse(is, generic));
+      EXPECT_EQ(v, generic.value().GetInt64());
+      EXPECT_EQ(contiguous.type(), generic.type());
+    }
+    if (i == 1000000000000000000) {
+      break;
+    }
+  }
 }
 
 #define TEST_DOUBLE(_expect, _json)                                            \
@@ -206,19 +240,21 @@ TEST(parse, double) {
   TEST_DOUBLE(1.234E+10, "1.234E+10");
   TEST_DOUBLE(1.234E-10, "1.234E-10");
 
-  //  TEST_DOUBLE(0.0, "1e-10000"); /* must underflow */
-  //  TEST_DOUBLE(1.0000000000000002, "1.0000000000000002"); /* the smallest
-  //  number > 1 */ TEST_DOUBLE(4.9406564584124654e-324,
-  //  "4.9406564584124654e-324"); /* minimum denormal */
-  //  TEST_DOUBLE(-4.9406564584124654e-324, "-4.9406564584124654e-324");
-  //  TEST_DOUBLE(2.2250738585072009e-308, "2.2250738585072009e-308");  /* Max
-  //  subnormal double */ TEST_DOUBLE(-2.2250738585072009e-308,
-  //  "-2.2250738585072009e-308"); TEST_DOUBLE(2.2250738585072014e-308,
-  //  "2.2250738585072014e-308");  /* Min normal positive double */
-  //  TEST_DOUBLE(-2.2250738585072014e-308, "-2.2250738585072014e-308");
-  //  TEST_DOUBLE(1.7976931348623157e+308, "1.7976931348623157e+308");  /* Max
-  //  double */ TEST_DOUBLE(-1.7976931348623157e+308,
-  //  "-1.7976931348623157e+308");
+  TEST_DOUBLE(0.0, "1e-10000"); /* must underflow */
+  /* the smallest number > 1 */
+  TEST_DOUBLE(1.0000000000000002, "1.0000000000000002");
+  /* minimum denormal */
+  TEST_DOUBLE(4.9406564584124654e-324, "4.9406564584124654e-324");
+  TEST_DOUBLE(-4.9406564584124654e-324, "-4.9406564584124654e-324");
+  /* max subnormal double */
+  TEST_DOUBLE(2.2250738585072009e-308, "2.2250738585072009e-308");
+  TEST_DOUBLE(-2.2250738585072009e-308, "-2.2250738585072009e-308");
+  /* min normal positive double */
+  TEST_DOUBLE(2.2250738585072014e-308, "2.2250738585072014e-308");
+  TEST_DOUBLE(-2.2250738585072014e-308, "-2.2250738585072014e-308");
+  /* max double */
+  TEST_DOUBLE(1.7976931348623157e+308, "1.7976931348623157e+308");
+  TEST_DOUBLE(-1.7976931348623157e+308, "-1.7976931348623157e+308");
 }
 
 #define TEST_STRING(_expect, _json)                                            \
@@ -364,6 +400,150 @@ TEST(parse, object) {
   }
 }
 
+TEST(parse, contiguous_stream) {
+  constexpr std::string_view json =
+      R"({ "a" : [ 1, -2.5, "x\ty", true, null ], "b" : "\u20AC" } )";
+
+  // StringReadStream takes the pointer-based path, IStreamWrapper the generic
+  neujson::StringReadStream read_stream(json);
+  neujson::Document contiguous;
+  EXPECT_EQ(neujson::error::ParseError::OK,
+            contiguous.ParseStream(read_stream));
+  EXPECT_FALSE(read_stream.hasNext());
+
+  std::stringstream iss{std::string(json)};
+  neujson::IStreamWrapper is(iss);
+  neujson::Document generic;
+  EXPECT_EQ(neujson::error::ParseError::OK, generic.ParseStream(is));
+
+  neujson::StringWriteStream contiguous_os;
+  neujson::Writer contiguous_writer(contiguous_os);
+  contiguous.WriteTo(contiguous_writer);
+  neujson::StringWriteStream generic_os;
+  neujson::Writer generic_writer(generic_os);
+  generic.WriteTo(generic_writer);
+  EXPECT_EQ(generic_os.get(), contiguous_os.get());
+}
+
+TEST(parse, padded_stream) {
+  // whitespace runs around every alignment, ending right at the input end
+  std::string json = "[";
+  for (std::size_t i = 0; i < 40; i++) {
+    json += std::string(i, ' ') + "\n\t" + std::to_string(i) +
+            std::string(i % 3, '\r') + ",";
+  }
+  json += R"( { "k" :    "v" } )" + std::string(37, ' ') + "]" +
+          std::string(70, ' ');
+
+  neujson::StringReadStream read_stream(json);
+  neujson::Document expect;
+  EXPECT_EQ(neujson::error::ParseError::OK, expect.ParseStream(read_stream));
+
+  neujson::PaddedReadStream padded_stream(json);
+  neujson::Document doc;
+  EXPECT_EQ(neujson::error::ParseError::OK, doc.ParseStream(padded_stream));
+  EXPECT_FALSE(padded_stream.hasNext());
+  EXPECT_EQ(41UL, doc.GetArray()->size());
+
+  neujson::StringWriteStream expect_os;
+  neujson::Writer expect_writer(expect_os);
+  expect.WriteTo(expect_writer);
+  neujson::StringWriteStream os;
+  neujson::Writer writer(os);
+  doc.WriteTo(writer);
+  EXPECT_EQ(expect_os.get(), os.get());
+
+  // the padding bytes are never taken for input
+  std::string buffer = "[1, 2]   ";
+  buffer.append(neujson::PaddedReadStream::kPadding, ' ');
+  neujson::PaddedReadStream in_place(buffer.data(), 9, buffer.size());
+  TestHandler test_handler;
+  EXPECT_EQ(neujson::error::ParseError::OK,
+            neujson::Reader::Parse(in_place, test_handler));
+  EXPECT_EQ(buffer.data() + 9, in_place.getAddr());
+}
+
+// records where the reader delivered strings from
+class ViewHandler : public TestHandler {
+public:
+  std::vector<std::string_view> views_;
+
+  bool String(const std::string_view str) {
+    views_.push_back(str);
+    return TestHandler::String(str);
+  }
+
+  bool Key(const std::string_view str) {
+    views_.push_back(str);
+    return TestHandler::Key(str);
+  }
+};
+
+TEST(parse, zero_copy_string) {
+  const std::string json =
+      R"({"plain":["", "long string without any escape in it", "a\nb"],)"
+      R"( "k\u0065y":"\u20AC x"})";
+  const auto in_source = [&json](const std::string_view str) {
+    return str.data() >= json.data() && str.data() < json.data() + json.size();
+  };
+
+  neujson::StringReadStream read_stream(json);
+  ViewHandler handler;
+  EXPECT_EQ(neujson::error::ParseError::OK,
+            neujson::Reader::Parse(read_stream, handler));
+  ASSERT_EQ(6UL, handler.views_.size());
+
+  // escape-free strings point into the input, escaped ones are unescaped
+  EXPECT_TRUE(in_source(handler.views_[0]));
+  EXPECT_EQ("plain", handler.views_[0]);
+  EXPECT_TRUE(in_source(handler.views_[1]));
+  EXPECT_EQ("", handler.views_[1]);
+  EXPECT_TRUE(in_source(handler.views_[2]));
+  EXPECT_EQ("long string without any escape in it", handler.views_[2]);
+  EXPECT_FALSE(in_source(handler.views_[3]));
+  EXPECT_FALSE(in_source(handler.views_[4]));
+  EXPECT_FALSE(in_source(handler.views_[5]));
+}
+
+TEST(parse, insitu) {
+  constexpr std::string_view json =
+      R"({"abc" : ["x\ty", "\uD834\uDD1E!", "plain", ""], "d":-1.5})";
+  std::string buffer(json);
+  const auto in_buffer = [&buffer](const std::string_view str) {
+    return str.data() >= buffer.data() &&
+           str.data() <= buffer.data() + buffer.size();
+  };
+
+  neujson::Document expect;
+  EXPECT_EQ(neujson::error::ParseError::OK, expect.Parse(json));
+  neujson::Document doc;
+  EXPECT_EQ(neujson::error::ParseError::OK, doc.ParseInsitu(buffer.data()));
+
+  // every string lives in the parsed buffer, escaped ones included
+  const auto &array = doc["abc"];
+  EXPECT_TRUE(in_buffer(doc.MemberBegin()->key_.GetStringView()));
+  EXPECT_EQ("x\ty", array[0].GetStringView());
+  EXPECT_TRUE(in_buffer(array[0].GetStringView()));
+  EXPECT_EQ("\xF0\x9D\x84\x9E!", array[1].GetStringView());
+  EXPECT_TRUE(in_buffer(array[1].GetStringView()));
+  EXPECT_TRUE(in_buffer(array[2].GetStringView()));
+  EXPECT_EQ("", array[3].GetStringView());
+  EXPECT_EQ(-1.5, doc["d"].GetDouble());
+
+  neujson::StringWriteStream expect_os;
+  neujson::Writer expect_writer(expect_os);
+  expect.WriteTo(expect_writer);
+  neujson::StringWriteStream os;
+  neujson::Writer writer(os);
+  doc.WriteTo(writer);
+  EXPECT_EQ(expect_os.get(), os.get());
+
+  std::string bad = R"(["a\x"])";
+  neujson::Document bad_doc;
+  EXPECT_EQ(neujson::error::ParseError::BAD_STRING_ESCAPE,
+            bad_doc.ParseInsitu(bad.data(), bad.size()));
+}
+
 #define TEST_PARSE_ERROR(_error, _json)                                        \
   do {                                                                         \
     std::string_view ss((_json));                                              \
@@ -372,6 +552,41 @@ TEST(parse, object) {
     EXPECT_EQ((_error), neujson::Reader::Parse(read_stream, test_handler));    \
   } while (0) //
 
+TEST(parse, long_string) {
+  // escapes and stops at every offset of the vector blocks, through the SIMD
+  // scan of contiguous input, in place, and through the generic stream path
+  for (std::size_t length = 0; length < 160; length++) {
+    for (const std::string_view escape : {"\\n", "\\u00e9", "\\\""}) {
+      std::string body(length, 'x');
+      body.insert(length / 3, escape);
+      const std::string json = "[\"" + body + "\",\"" + body + "\"]";
+
+      neujson::Document expect;
+      ASSERT_EQ(neujson::error::OK, expect.Parse(json)) << json;
+      const std::string_view str = expect[0].GetStringView();
+      EXPECT_EQ(length + (escape[1] == 'u' ? 2 : 1), str.size());
+      EXPECT_EQ(str, expect[1].GetStringView());
+
+      std::string buffer(json);
+      neujson::Document insitu;
+      ASSERT_EQ(neujson::error::OK, insitu.ParseInsitu(buffer.data()));
+      EXPECT_EQ(str, insitu[0].GetStringView());
+
+      std::stringstream iss{json};
+      neujson::IStreamWrapper is(iss);
+      neujson::Document generic;
+      ASSERT_EQ(neujson::error::OK, generic.ParseStream(is));
+      EXPECT_EQ(str, generic[1].GetStringView());
+
+      // a missing closing quote or a raw control character fails the same way
+      const std::string open = "\"" + body;
+      TEST_PARSE_ERROR(neujson::error::MISS_QUOTATION_MARK, open);
+      const std::string control = "\"" + body + '\x1F' + body + "\"";
+      TEST_PARSE_ERROR(neujson::error::BAD_STRING_CHAR, control);
+    }
+  }
+}
+
 TEST(parse, expect_value) {
   TEST_PARSE_ERROR(neujson::error::EXPECT_VALUE, "");
   TEST_PARSE_ERROR(neujson::error::EXPECT_VALUE, " ");
@@ -411,6 +626,10 @@ TEST(parse, root_not_singular) {
 TEST(parse, number_too_big) {
   TEST_PARSE_ERROR(neujson::error::NUMBER_TOO_BIG, "1e309");
   TEST_PARSE_ERROR(neujson::error::NUMBER_TOO_BIG, "-1e309");
+  TEST_PARSE_ERROR(neujson::error::NUMBER_TOO_BIG, "9223372036854775808");
+  TEST_PARSE_ERROR(neujson::error::NUMBER_TOO_BIG, "-9223372036854775809");
+  TEST_PARSE_ERROR(neujson::error::NUMBER_TOO_BIG, "18446744073709551616");
+  TEST_PARSE_ERROR(neujson::error::NUMBER_TOO_BIG, "123456789012345678901");
 }
 
 TEST(parse, miss_quotation_mark) {
@@ -428,6 +647,8 @@ TEST(parse, bad_string_escape) {
 TEST(parse, bad_string_char) {
   TEST_PARSE_ERROR(neujson::error::BAD_STRING_CHAR, "\"\x01\"");
   TEST_PARSE_ERROR(neujson::error::BAD_STRING_CHAR, "\"\x1F\"");
+  TEST_PARSE_ERROR(neujson::error::BAD_STRING_CHAR,
+                   std::string_view("\"\0\"", 3));
 }
 
 TEST(parse, bad_unicode_hex) {
@@ -485,6 +706,237 @@ TEST(parse, miss_comma_or_curly_bracket) {
   TEST_PARSE_ERROR(neujson::error::MISS_COMMA_OR_CURLY_BRACKET, R"({"a":{})");
 }
 
+TEST(parse, depth_exceeded) {
+  const auto nested = [](const std::size_t depth, const char open,
+                         const std::string_view close) {
+    std::string json;
+    for (std::size_t i = 0; i < depth; i++) {
+      json += open;
+      if (open == '{') {
+        json += R"("k":)";
+      }
+    }
+    json += "0";
+    for (std::size_t i = 0; i < depth; i++) {
+      json += close;
+    }
+    return json;
+  };
+
+  for (const char open : {'[', '{'}) {
+    const std::string_view close = open == '[' ? "]" : "}";
+    const std::string deepest = nested(NEUJSON_PARSE_MAX_DEPTH, open, close);
+    neujson::Document doc;
+    EXPECT_EQ(neujson::error::OK, doc.Parse(deepest));
+
+    const std::string too_deep =
+        nested(NEUJSON_PARSE_MAX_DEPTH + 1, open, close);
+    TEST_PARSE_ERROR(neujson::error::DEPTH_EXCEEDED, too_deep);
+  }
+
+  // hostile input is rejected without walking all of it
+  const std::string hostile(1 << 20, '[');
+  TEST_PARSE_ERROR(neujson::error::DEPTH_EXCEEDED, hostile);
+}
+
+TEST(parse, flags) {
+  constexpr unsigned kStrict = neujson::ParseFlags::kFullPrecision;
+
+  // NaN and Infinity are opt-in
+  for (const char *json : {"NaN", "Infinity", "[1,NaN]"}) {
+    neujson::Document doc;
+    EXPECT_EQ(neujson::error::OK, doc.Parse(json));
+    neujson::Document strict;
+    EXPECT_EQ(neujson::error::BAD_VALUE, strict.Parse<kStrict>(json));
+  }
+
+  // concatenated values, one at a time
+  const std::string_view json = R"({"a":1} [2]  "3")";
+  neujson::StringReadStream read_stream(json);
+  for (const neujson::Type type :
+       {neujson::NEU_OBJECT, neujson::NEU_ARRAY, neujson::NEU_STRING}) {
+    neujson::Document doc;
+    EXPECT_EQ(neujson::error::OK,
+              doc.ParseStream<neujson::ParseFlags::kStopWhenDone>(read_stream));
+    EXPECT_EQ(type, doc.GetType());
+  }
+  EXPECT_FALSE(read_stream.hasNext());
+
+  // normal precision stays within a few ulp
+  for (const char *number :
+       {"0.1", "3.14159265358979323846", "1.7976931348623157e308",
+        "2.2250738585072014e-308", "4.9406564584124654e-324", "1e-320",
+        "123456789012345678901234567890.5e-10"}) {
+    neujson::Document expect;
+    EXPECT_EQ(neujson::error::OK, expect.Parse(number));
+    neujson::Document doc;
+    EXPECT_EQ(neujson::error::OK,
+              doc.Parse<neujson::ParseFlags::kNone>(number));
+    const double e = expect.GetDouble();
+    EXPECT_NEAR(e, doc.GetDouble(), e * 1e-15) << number;
+  }
+}
+
+TEST(parse, validate_utf8) {
+  constexpr unsigned kValidate =
+      neujson::ParseFlags::kDefault | neujson::ParseFlags::kValidateUtf8;
+  const std::string long_run(100, 'x');
+
+  for (const std::string &json :
+       {std::string(R"(["caf\u00e9", "\uD834\uDD1E", "\u0000"])"),
+        std::string("[\"caf\xC3\xA9\", \"\xF0\x9D\x84\x9E\"]"),
+        std::string("{\"\xE2\x82\xAC\":\"") + long_run +
+            "\xE2\x82\xAC\\n\xE2\x82\xAC" + long_run + "\"}"}) {
+    neujson::Document doc;
+    EXPECT_EQ(neujson::error::OK, doc.Parse<kValidate>(json)) << json;
+    std::stringstream iss{json};
+    neujson::IStreamWrapper is(iss);
+    neujson::Document generic;
+    EXPECT_EQ(neujson::error::OK, generic.ParseStream<kValidate>(is)) << json;
+  }
+
+  for (const std::string &json :
+       {std::string("\"\xC3\""), std::string("[\"\xED\xA0\x80\"]"),
+        std::string("{\"k\xFF\":1}"),
+        std::string("\"") + long_run + "\xC3\x28" + long_run + "\"",
+        std::string("\"\xE2\x82\\n\"")}) {
+    // accepted as is without the flag
+    neujson::Document lenient;
+    EXPECT_EQ(neujson::error::OK, lenient.Parse(json));
+
+    neujson::Document doc;
+    EXPECT_EQ(neujson::error::BAD_STRING_UTF8, doc.Parse<kValidate>(json));
+    std::string buffer(json);
+    neujson::Document insitu;
+    EXPECT_EQ(neujson::error::BAD_STRING_UTF8,
+              insitu.ParseInsitu<kValidate>(buffer.data()));
+    std::stringstream iss{json};
+    neujson::IStreamWrapper is(iss);
+    neujson::Document generic;
+    EXPECT_EQ(neujson::error::BAD_STRING_UTF8,
+              generic.ParseStream<kValidate>(is));
+  }
+
+  // a low surrogate without a high one can not be encoded
+  neujson::Document doc;
+  EXPECT_EQ(neujson::error::BAD_UNICODE_SURROGATE,
+            doc.Parse<kValidate>(R"("\uDC00")"));
+}
+
+TEST(parse, nested_error) {
+  // errors deep inside containers reach the caller unchanged
+  TEST_PARSE_ERROR(neujson::error::BAD_UNICODE_HEX,
+                   R"([[[{"a":["\u12G4"]}]]])");
+  TEST_PARSE_ERROR(neujson::error::NUMBER_TOO_BIG, R"({"a":[1,{"b":1e309}]})");
+  TEST_PARSE_ERROR(neujson::error::MISS_COLON, R"([{"a":{"b" 1}}])");
+}
+
+TEST(parse, error_offset) {
+  // the offset is where the reader stopped: the byte at fault, or the end,
+  // the same on every kind of stream
+  const auto expect_offset = [](const std::string &json,
+                                const std::size_t offset) {
+    constexpr unsigned kValidate =
+        neujson::ParseFlags::kDefault | neujson::ParseFlags::kValidateUtf8;
+    neujson::Document doc;
+    EXPECT_EQ(offset, doc.Parse<kValidate>(json).offset()) << json;
+    std::string buffer(json);
+    neujson::Document insitu;
+    EXPECT_EQ(offset, insitu.ParseInsitu<kValidate>(buffer.data()).offset())
+        << json;
+    std::stringstream iss{json};
+    char chunk[4];
+    neujson::IStreamWrapper is(iss, chunk);
+    neujson::Document generic;
+    EXPECT_EQ(offset, generic.ParseStream<kValidate>(is).offset()) << json;
+  };
+  const std::pair<std::string_view, std::size_t> kCases[] = {
+      {"[1, 2]", 6},
+      {"", 0},
+      {"[1, 2", 5},
+      {"[1 2]", 3},
+      {"[1] x", 4},
+      {"{1: 2}", 1},
+      {R"({"a" 1})", 5},
+      {R"({"a": 1 x})", 8},
+      {R"(["a\x"])", 5},
+      {"[tru]", 4},
+      {"[nul", 4},
+      {"\"abc\x01 def\"", 4},
+      // ill-formed UTF-8: the first byte which can not continue the sequence
+      {"[\"\xC3\x28\"]", 3},
+      {"[\"\xC3\"]", 3},
+      {"[\"\xFF\"]", 2},
+      {"[\"\xE2\x82\\n\"]", 4},
+      {"\"\xF0\x9D\x84", 4},
+  };
+  for (const auto &[json, offset] : kCases) {
+    expect_offset(std::string(json), offset);
+  }
+  // past the first SIMD block, and after an escape
+  const std::string long_run(1000, 'x');
+  expect_offset("\"" + long_run + "\xC3\x28\"", 1002);
+  expect_offset("\"\\n" + long_run + "\xED\xA0\x80\"", 1004);
+
+  constexpr std::string_view kJson = "{\n  \"a\": [1,\n        2 3]\n}";
+  neujson::Document doc;
+  const auto result = doc.Parse(kJson);
+  EXPECT_EQ(neujson::error::MISS_COMMA_OR_SQUARE_BRACKET, result);
+  EXPECT_EQ(23, result.offset());
+  const auto position = result.position(kJson);
+  EXPECT_EQ(3, position.line);
+  EXPECT_EQ(11, position.column);
+  EXPECT_EQ(1, neujson::ParseResult().position(kJson).column);
+
+  // streams without an address count the bytes they took, across refills
+  std::string json = "[";
+  for (int i = 0; i < 100; ++i) {
+    json += "1234, ";
+  }
+  json += "5 6]";
+  std::stringstream iss{json};
+  char buffer[16];
+  neujson::IStreamWrapper is(iss, buffer);
+  TestHandler handler;
+  const auto stream_result = neujson::Reader::Parse(is, handler);
+  EXPECT_EQ(neujson::error::MISS_COMMA_OR_SQUARE_BRACKET, stream_result);
+  EXPECT_EQ(json.size() - 2, stream_result.offset());
+}
+
+// stops the parse once it has seen a given number of events
+class StopHandler : neujson::NonCopyable {
+  int events_;
+
+  bool next() { return --events_ > 0; }
+
+public:
+  explicit StopHandler(const int events) : events_(events) {}
+
+  bool Null() { return next(); }
+  bool Bool(bool) { return next(); }
+  bool Int32(int32_t) { return next(); }
+  bool Int64(int64_t) { return next(); }
+  bool Double(neujson::internal::Double) { return next(); }
+  bool String(std::string_view) { return next(); }
+  bool Key(std::string_view) { return next(); }
+  bool StartObject() { return next(); }
+  bool EndObject() { return next(); }
+  bool StartArray() { return next(); }
+  bool EndArray() { return next(); }
+};
+
+TEST(parse, user_stopped) {
+  // [ "a" 1 { "b" null "c" 2.5 } true ]: 11 events
+  constexpr std::string_view kJson = R"(["a",1,{"b":null,"c":2.5},true])";
+  for (int events = 1; events <= 12; events++) {
+    neujson::StringReadStream read_stream(kJson);
+    StopHandler handler(events);
+    EXPECT_EQ(events <= 11 ? neujson::error::USER_STOPPED
+                           : neujson::error::OK,
+              neujson::Reader::Parse(read_stream, handler));
+  }
+}
+
 #if defined(__GNUC__) || (defined(_MSC_VER) && !defined(__clang__))
 NEUJSON_DIAG_POP
 #endif
\ No newline at end of file
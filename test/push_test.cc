@@ -0,0 +1,231 @@
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "neujson/document.h"
+#include "neujson/exception.h"
+#include "neujson/push_reader.h"
+#include "neujson/reader.h"
+#include "neujson/string_read_stream.h"
+#include "neujson/string_write_stream.h"
+#include "neujson/writer.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+struct Result {
+  neujson::error::ParseError err;
+  std::size_t offset;
+  std::string events;
+};
+
+template <unsigned Flags = neujson::ParseFlags::kDefault>
+Result ParseWhole(const std::string_view json) {
+  neujson::StringReadStream read_stream(json);
+  neujson::StringWriteStream os;
+  neujson::Writer writer(os);
+  const auto result = neujson::Reader::Parse<Flags>(read_stream, writer);
+  return {result.err(), result.offset(), std::string(os.get())};
+}
+
+// feed the input cut at the given offsets
+template <unsigned Flags = neujson::ParseFlags::kDefault>
+Result ParsePushed(neujson::PushReader &reader, const std::string_view json,
+                   const std::vector<std::size_t> &cuts) {
+  neujson::StringWriteStream os;
+  neujson::Writer writer(os);
+  std::size_t begin = 0;
+  for (const std::size_t cut : cuts) {
+    const auto status =
+        reader.Parse<Flags>(json.substr(begin, cut - begin), writer);
+    begin = cut;
+    if (status != neujson::error::NEED_MORE_INPUT &&
+        status != neujson::error::OK) {
+      break;
+    }
+  }
+  if (begin != json.size()) {
+    (void)reader.Parse<Flags>(json.substr(begin), writer);
+  }
+  const auto result = reader.Finish<Flags>(writer);
+  return {result.err(), result.offset(), std::string(os.get())};
+}
+
+// every single cut, and random cuts into many pieces
+void ExpectSameParse(neujson::PushReader &reader, const std::string_view json,
+                     std::mt19937 &rng) {
+  const auto expect = ParseWhole(json);
+  for (std::size_t cut = 0; cut <= json.size(); ++cut) {
+    const auto result = ParsePushed(reader, json, {cut});
+    EXPECT_EQ(expect.err, result.err) << json << " cut at " << cut;
+    EXPECT_EQ(expect.offset, result.offset) << json << " cut at " << cut;
+    EXPECT_EQ(expect.events, result.events) << json << " cut at " << cut;
+  }
+  std::uniform_int_distribution<std::size_t> piece(0, 4);
+  std::vector<std::size_t> cuts;
+  for (std::size_t cut = piece(rng); cut < json.size(); cut += piece(rng)) {
+    cuts.push_back(cut);
+  }
+  const auto result = ParsePushed(reader, json, cuts);
+  EXPECT_EQ(expect.err, result.err) << json;
+  EXPECT_EQ(expect.offset, result.offset) << json;
+  EXPECT_EQ(expect.events, result.events) << json;
+}
+
+} // namespace
+
+TEST(push, status) {
+  neujson::PushReader reader;
+  neujson::Document doc;
+  EXPECT_EQ(neujson::error::NEED_MORE_INPUT, reader.Parse(R"({"ke)", doc));
+  EXPECT_EQ(neujson::error::NEED_MORE_INPUT, reader.Parse(R"(y": [1, 2)", doc));
+  EXPECT_EQ(neujson::error::NEED_MORE_INPUT, reader.Parse("3", doc));
+  EXPECT_EQ(neujson::error::OK, reader.Parse("]}", doc));
+  EXPECT_EQ(neujson::error::OK, reader.Parse("  \n", doc));
+  EXPECT_EQ(neujson::error::OK, reader.Finish(doc));
+  EXPECT_EQ(23, doc["key"][1].GetInt32());
+
+  // a root number is complete only once something follows it
+  neujson::Document number;
+  EXPECT_EQ(neujson::error::NEED_MORE_INPUT, reader.Parse("12", number));
+  EXPECT_EQ(neujson::error::NEED_MORE_INPUT, reader.Parse("34", number));
+  EXPECT_EQ(neujson::error::OK, reader.Finish(number));
+  EXPECT_EQ(1234, number.GetInt32());
+
+  // errors stick until Finish(), which readies the reader for the next input
+  neujson::Document bad;
+  EXPECT_EQ(neujson::error::MISS_COLON, reader.Parse(R"({"a" 1})", bad));
+  EXPECT_EQ(neujson::error::MISS_COLON, reader.Parse("[]", bad));
+  EXPECT_EQ(neujson::error::MISS_COLON, reader.Finish(bad));
+  neujson::Document empty;
+  EXPECT_EQ(neujson::error::EXPECT_VALUE, reader.Finish(empty));
+  neujson::Document next;
+  EXPECT_EQ(neujson::error::OK, reader.Parse("[true]", next));
+  EXPECT_EQ(neujson::error::OK, reader.Finish(next));
+}
+
+TEST(push, chunks) {
+  neujson::PushReader reader;
+  std::mt19937 rng(20240610);
+  const std::string_view kJson[] = {
+      "null",
+      " true ",
+      "-1.5e3",
+      R"("a\"b\\")",
+      R"(["€", "𝄞", "x\ty"])",
+      " [ 1 , [ ] , { } , \"x\" ] ",
+      R"({"a" : [1, 2, {"b": null, "c": [true, false]}], "d": "€"})",
+      R"([1.7976931348623157e308, -0, 123456789012345678, NaN, -Infinity])",
+      // errors at every kind of position, and input ending everywhere
+      "",
+      "  ",
+      "nul",
+      "[1,]",
+      "[1 2]",
+      "[1\"a\"]",
+      "12a",
+      "[12a]",
+      "{\"a\":1\"b\":2}",
+      "{\"a\"x:1}",
+      "{\"a\"}",
+      "{\"a\":}",
+      "{1:2}",
+      "{\"a\":1,}",
+      "[\"a\\x\"]",
+      "[\"a\\u12x4\"]",
+      "[\"abc",
+      "[\"a\\\"]",
+      "[1]x",
+      "null x",
+      "[1",
+      "[1,",
+      "{",
+      "{\"a\"",
+      "{\"a\":",
+      "{\"a\":1",
+      "[\"\x01\"]",
+      "1e309",
+  };
+  for (const auto json : kJson) {
+    ExpectSameParse(reader, json, rng);
+  }
+
+  // strings long enough for the vector scan, escapes cut anywhere
+  std::string big = "[";
+  for (int i = 0; i < 20; ++i) {
+    big += R"({"key \"\\é" : [1, "a long string without escapes"]},)";
+  }
+  big += "0]";
+  ExpectSameParse(reader, big, rng);
+}
+
+TEST(push, random_errors) {
+  const std::string json =
+      R"({"a" : [1, -2.5e-3, "x\ty\"", true, null, {}], "b\\" : {"c": []},)"
+      R"( "d": ["€", false, 0, 12345678901234567890] })";
+  neujson::PushReader reader;
+  std::mt19937 rng(20240611);
+  std::uniform_int_distribution<std::size_t> position(0, json.size() - 1);
+  static constexpr char kAlphabet[] = {'"', '\\', '{', '}', '[', ']', ':',
+                                       ',', ' ', 'a', '1', 'e', 'u', '\0'};
+  std::uniform_int_distribution<std::size_t> pick(0, sizeof(kAlphabet) - 1);
+  std::uniform_int_distribution<std::size_t> cut(0, json.size());
+  for (int round = 0; round < 2000; ++round) {
+    std::string mutated = json;
+    for (int i = 0; i <= round % 3; ++i) {
+      mutated[position(rng)] = kAlphabet[pick(rng)];
+    }
+    const auto expect = ParseWhole(mutated);
+    auto first = cut(rng);
+    auto second = cut(rng);
+    if (first > second) {
+      std::swap(first, second);
+    }
+    const auto result = ParsePushed(reader, mutated, {first, second});
+    EXPECT_EQ(expect.err, result.err) << mutated;
+    EXPECT_EQ(expect.offset, result.offset) << mutated;
+    EXPECT_EQ(expect.events, result.events) << mutated;
+  }
+}
+
+TEST(push, flags) {
+  neujson::PushReader reader;
+  constexpr auto kStop = neujson::ParseFlags::kStopWhenDone;
+  for (const std::string_view json : {"[1] [2]", "12a", "{} x", "\"a\" 1"}) {
+    const auto expect = ParseWhole<kStop>(json);
+    for (std::size_t cut = 0; cut <= json.size(); ++cut) {
+      const auto result = ParsePushed<kStop>(reader, json, {cut});
+      EXPECT_EQ(expect.err, result.err) << json << " cut at " << cut;
+      EXPECT_EQ(expect.offset, result.offset) << json << " cut at " << cut;
+      EXPECT_EQ(expect.events, result.events) << json << " cut at " << cut;
+    }
+  }
+
+  // ill-formed UTF-8 is reported at the byte at fault wherever it is cut
+  constexpr auto kUtf8 = neujson::ParseFlags::kValidateUtf8;
+  for (const std::string_view json :
+       {"[\"\xC3\x28\"]", "{\"a\xE2\x82\\n\":1}", "[\"x\xF0\x9D\x84\"]"}) {
+    const auto expect = ParseWhole<kUtf8>(json);
+    for (std::size_t cut = 0; cut <= json.size(); ++cut) {
+      const auto result = ParsePushed<kUtf8>(reader, json, {cut});
+      EXPECT_EQ(neujson::error::BAD_STRING_UTF8, result.err)
+          << json << " cut at " << cut;
+      EXPECT_EQ(expect.offset, result.offset) << json << " cut at " << cut;
+    }
+  }
+
+  neujson::Document doc;
+  EXPECT_EQ(neujson::error::BAD_VALUE,
+            reader.Parse<neujson::ParseFlags::kNone>("[NaN]", doc));
+  EXPECT_EQ(neujson::error::BAD_VALUE,
+            reader.Finish<neujson::ParseFlags::kNone>(doc));
+  neujson::Document utf8;
+  EXPECT_EQ(neujson::error::NEED_MORE_INPUT,
+            reader.Parse<neujson::ParseFlags::kValidateUtf8>("[\"\xC3", utf8));
+  EXPECT_EQ(neujson::error::BAD_STRING_UTF8,
+            reader.Parse<neujson::ParseFlags::kValidateUtf8>("\"]", utf8));
+  EXPECT_EQ(neujson::error::BAD_STRING_UTF8,
+            reader.Finish<neujson::ParseFlags::kValidateUtf8>(utf8));
+}
@@ -0,0 +1,191 @@
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "neujson/internal/simd.h"
+
+#include "gtest/gtest.h"
+
+using namespace neujson;
+using namespace neujson::internal;
+
+namespace {
+
+constexpr simd::Implementation kImplementations[] = {
+    simd::SCALAR, simd::SSE2, simd::SSE42,
+    simd::AVX2,   simd::AVX512, simd::NEON};
+
+// mostly the bytes the kernels stop at, so every lane position gets hit
+std::string RandomInput(std::mt19937 &rng, const std::size_t length) {
+  static constexpr char kAlphabet[] = {' ',  '\n', '\r', '\t', '"',  '\\',
+                                       '\0', '\x1F', 'a', '{',  '\x7F',
+                                       '\x80', '\xFF', '0', ':', '\x20'};
+  std::string s(length, ' ');
+  std::uniform_int_distribution<std::size_t> pick(0, sizeof(kAlphabet) - 1);
+  std::uniform_int_distribution<std::size_t> sparse(0, 40);
+  for (auto &ch : s) {
+    // long runs of whitespace / plain characters with rare stops
+    ch = sparse(rng) == 0 ? kAlphabet[pick(rng)] : ' ';
+  }
+  return s;
+}
+
+} // namespace
+
+TEST(simd, active_implementation) {
+  const auto active = GetActiveImplementation();
+  EXPECT_TRUE(CpuSupports(active));
+  EXPECT_EQ(DetectImplementation(), active);
+  EXPECT_STRNE("", ImplementationStr(active));
+  EXPECT_STREQ("scalar", ImplementationStr(simd::SCALAR));
+  EXPECT_STREQ("avx2", ImplementationStr(simd::AVX2));
+}
+
+TEST(simd, skip_whitespace) {
+  std::mt19937 rng(20240604);
+  for (const auto impl : kImplementations) {
+    if (!CpuSupports(impl)) {
+      continue;
+    }
+    const auto &kernels = GetKernels(impl);
+    EXPECT_EQ(impl, kernels.implementation);
+    for (std::size_t length = 0; length < 200; ++length) {
+      const std::string s = RandomInput(rng, length);
+      for (std::size_t offset = 0; offset <= length; ++offset) {
+        const char *p = s.data() + offset;
+        const char *end = s.data() + length;
+        EXPECT_EQ(SkipWhitespaceScalar(p, end), kernels.skip_whitespace(p, end))
+            << ImplementationStr(impl) << " length " << length << " offset "
+            << offset;
+      }
+    }
+  }
+}
+
+TEST(simd, scan_string) {
+  std::mt19937 rng(20240605);
+  for (const auto impl : kImplementations) {
+    if (!CpuSupports(impl)) {
+      continue;
+    }
+    const auto &kernels = GetKernels(impl);
+    for (std::size_t length = 0; length < 200; ++length) {
+      std::string s = RandomInput(rng, length);
+      // string bodies are rarely whitespace, swap in plain characters
+      for (auto &ch : s) {
+        ch = ch == ' ' ? 'x' : ch;
+      }
+      for (std::size_t offset = 0; offset <= length; ++offset) {
+        const char *p = s.data() + offset;
+        const char *end = s.data() + length;
+        EXPECT_EQ(ScanStringScalar(p, end), kernels.scan_string(p, end))
+            << ImplementationStr(impl) << " length " << length << " offset "
+            << offset;
+      }
+    }
+  }
+}
+
+TEST(simd, validate_utf8) {
+  // well-formed and ill-formed sequences, see table 3-7 of the Unicode standard
+  constexpr std::string_view kValid[] = {
+      "",
+      "ascii",
+      "\xC2\x80",
+      "\xDF\xBF",
+      "\xE0\xA0\x80",
+      "\xED\x9F\xBF",
+      "\xEE\x80\x80",
+      "\xEF\xBF\xBF",
+      "\xF0\x90\x80\x80",
+      "\xF4\x8F\xBF\xBF",
+      "\xE2\x82\xAC x \xF0\x9F\x98\x80",
+  };
+  constexpr std::string_view kInvalid[] = {
+      "\x80",             // lone continuation
+      "\xC0\x80",         // overlong
+      "\xC1\xBF",         // overlong
+      "\xC2",             // cut short
+      "\xC2\x41",         // not a continuation
+      "\xE0\x80\x80",     // overlong
+      "\xE0\x9F\xBF",     // overlong
+      "\xED\xA0\x80",     // surrogate
+      "\xED\xBF\xBF",     // surrogate
+      "\xE2\x82",         // cut short
+      "\xE2\x82\x41",     // not a continuation
+      "\xE2\x82\xAC\xAC", // one continuation too many
+      "\xF0\x80\x80\x80", // overlong
+      "\xF0\x8F\xBF\xBF", // overlong
+      "\xF4\x90\x80\x80", // above U+10FFFF
+      "\xF5\x80\x80\x80", // above U+10FFFF
+      "\xF0\x9F\x98",     // cut short
+      "\xFF",             // never in UTF-8
+  };
+
+  std::mt19937 rng(20240606);
+  std::uniform_int_distribution<std::size_t> pad(0, 40);
+  for (const auto impl : kImplementations) {
+    if (!CpuSupports(impl)) {
+      continue;
+    }
+    const auto &kernels = GetKernels(impl);
+    // every case at every position of the vector blocks
+    for (std::size_t offset = 0; offset < 70; ++offset) {
+      for (const auto valid : kValid) {
+        std::string s = std::string(offset, 'a') + std::string(valid) +
+                        std::string(pad(rng), 'b');
+        EXPECT_TRUE(kernels.validate_utf8(s.data(), s.data() + s.size()))
+            << ImplementationStr(impl) << " offset " << offset;
+      }
+      for (const auto invalid : kInvalid) {
+        std::string s = std::string(offset, 'a') + std::string(invalid) +
+                        std::string(pad(rng), 'b');
+        EXPECT_FALSE(kernels.validate_utf8(s.data(), s.data() + s.size()))
+            << ImplementationStr(impl) << " offset " << offset;
+      }
+    }
+
+    // random mixes of well-formed sequences and stray bytes
+    constexpr std::string_view kPieces[] = {
+        "a",        "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80",
+        "\x80",     "\xC3",     "\xED\xA0\x80", "\xF4\x90\x80\x80"};
+    std::uniform_int_distribution<std::size_t> pick(0, 3);
+    std::uniform_int_distribution<std::size_t> stray(0, 300);
+    for (std::size_t length = 0; length < 200; ++length) {
+      std::string s;
+      while (s.size() < length) {
+        s += kPieces[pick(rng) + (stray(rng) == 0 ? 4 : 0)];
+      }
+      EXPECT_EQ(ValidateUtf8Scalar(s.data(), s.data() + s.size()),
+                kernels.validate_utf8(s.data(), s.data() + s.size()))
+          << ImplementationStr(impl) << " length " << length;
+    }
+  }
+}
+
+TEST(simd, classify_block) {
+  // with the look-alikes of the structural characters one bit away
+  static constexpr char kAlphabet[] = {
+      '"', '\\', '{', '}', '[', ']', ':', ',', ' ', '\n', '\r', '\t',
+      'a', '\0', ';', '\x1A', '\x0C', '\x02', '\xFB', '\xDB'};
+  std::mt19937 rng(20240609);
+  std::uniform_int_distribution<std::size_t> pick(0, sizeof(kAlphabet) - 1);
+  for (const auto impl : kImplementations) {
+    if (!CpuSupports(impl)) {
+      continue;
+    }
+    const auto &kernels = GetKernels(impl);
+    for (int round = 0; round < 1000; ++round) {
+      char block[64];
+      for (auto &ch : block) {
+        ch = kAlphabet[pick(rng)];
+      }
+      const BlockMasks expect = ClassifyBlockScalar(block);
+      const BlockMasks masks = kernels.classify_block(block);
+      EXPECT_EQ(expect.quote, masks.quote) << ImplementationStr(impl);
+      EXPECT_EQ(expect.backslash, masks.backslash) << ImplementationStr(impl);
+      EXPECT_EQ(expect.op, masks.op) << ImplementationStr(impl);
+      EXPECT_EQ(expect.whitespace, masks.whitespace) << ImplementationStr(impl);
+    }
+  }
+}
@@ -0,0 +1,43 @@
+// plain reference counts for this program, before any neujson header
+#define NEUJSON_SINGLE_THREADED_REFCOUNT 1
+
+#include <string>
+#include <string_view>
+
+#include "neujson/document.h"
+#include "neujson/string_write_stream.h"
+#include "neujson/value.h"
+#include "neujson/writer.h"
+
+#include "gtest/gtest.h"
+
+TEST(single_threaded, refcount) {
+  EXPECT_EQ(16UL, sizeof(neujson::Value));
+
+  const std::string long_string(100, 'x');
+  auto *value = new neujson::Value(long_string);
+  neujson::Value copy = *value;
+  EXPECT_EQ(2UL, copy.UseCount());
+  delete value;
+  EXPECT_EQ(1UL, copy.UseCount());
+  EXPECT_EQ(long_string, copy.GetStringView());
+}
+
+TEST(single_threaded, document) {
+  constexpr std::string_view kJson =
+      R"({"a":[1,-2.5,"long enough to be a heap string",true,null],)"
+      R"("b":{"c":{},"d":[]},"e":""})";
+  auto *doc = new neujson::Document();
+  EXPECT_EQ(neujson::error::OK, doc->Parse(kJson));
+  const neujson::Value a = (*doc)["a"];
+  EXPECT_EQ(2UL, a.UseCount());
+  delete doc;
+  EXPECT_EQ(1UL, a.UseCount());
+  EXPECT_EQ("long enough to be a heap string", a[2].GetStringView());
+
+  neujson::StringWriteStream os;
+  neujson::Writer writer(os);
+  a.WriteTo(writer);
+  EXPECT_EQ(R"([1,-2.5,"long enough to be a heap string",true,null])",
+            os.get());
+}
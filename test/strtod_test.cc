@@ -4,6 +4,13 @@
 
 #include "neujson/internal/strtod.h"
 
+#include <cstring>
+
+#include <string>
+#include <string_view>
+
+#include "neujson/document.h"
+
 #include "gtest/gtest.h"
 
 #if defined(__clang__)
@@ -102,6 +109,106 @@ TEST(strtod, check_approximation_case) {
   EXPECT_EQ(49, hS_Exp5);
 }
 
+TEST(strtod, big_integer) {
+  const BigInteger a("123456789012345678901234567890", 30);
+  BigInteger b(1);
+  b.MultiplyPow5(29) <<= 29; // 10^29
+  EXPECT_TRUE(BigInteger(0).IsZero());
+  EXPECT_FALSE(b.IsZero());
+  EXPECT_EQ(1, a.Compare(b));
+  EXPECT_EQ(-1, b.Compare(a));
+
+  // |a - b| = 23456789012345678901234567890, either way round
+  const BigInteger expect("23456789012345678901234567890", 29);
+  BigInteger delta(0);
+  EXPECT_FALSE(a.Difference(b, &delta));
+  EXPECT_TRUE(delta == expect);
+  EXPECT_TRUE(b.Difference(a, &delta));
+  EXPECT_TRUE(delta == expect);
+  EXPECT_FALSE(a.Difference(a, &delta));
+  EXPECT_TRUE(delta.IsZero());
+
+  // shifts by less than a whole word
+  BigInteger c(3);
+  c <<= 70;
+  BigInteger d(3);
+  d.MultiplyPow5(0) <<= 64;
+  d <<= 6;
+  EXPECT_EQ(0, c.Compare(d));
+  EXPECT_FALSE(c == 3);
+}
+
+TEST(strtod, cached_power) {
+  for (int exp = -340; exp <= 308; exp++) {
+    int actual_exp;
+    const DiyFp power = GetCachedPower10(exp, &actual_exp);
+    EXPECT_LE(actual_exp, exp);
+    EXPECT_GT(actual_exp, exp - 8);
+    EXPECT_NE(0U, power.f_ >> 63); // normalized
+    if (actual_exp >= 0 && actual_exp <= 27) {
+      // exact below 5^27 < 2^64
+      EXPECT_EQ(Pow10(actual_exp), std::ldexp(static_cast<double>(power.f_),
+                                              power.e_));
+    }
+  }
+}
+
+static uint64_t ParseBits(const std::string_view json) {
+  neujson::Document doc;
+  EXPECT_EQ(neujson::error::ParseError::OK, doc.Parse(json)) << json;
+  EXPECT_TRUE(doc.IsDouble()) << json;
+  const double d = doc.GetDouble();
+  uint64_t u;
+  std::memcpy(&u, &d, sizeof(u));
+  return u;
+}
+
+TEST(strtod, hard_rounding_cases) {
+  // Clinger fast path, with and without the exponent shift
+  EXPECT_EQ(0x3FB999999999999AU, ParseBits("0.1"));
+  EXPECT_EQ(0x44B52D02C7E14AF6U, ParseBits("1e23"));
+  EXPECT_EQ(0x4340000000000000U, ParseBits("9007199254740992.0"));
+
+  // 2^53 + 1 is halfway, ties to even; a tail breaks the tie
+  EXPECT_EQ(0x4340000000000000U, ParseBits("9007199254740993.0"));
+  EXPECT_EQ(0x4340000000000001U, ParseBits("9007199254740993.0000000001"));
+  EXPECT_EQ(0x4340000000000001U, ParseBits("9007199254740994.99"));
+
+  // 1 + 2^-53, exactly halfway between 1 and its successor
+  const std::string half =
+      "1.00000000000000011102230246251565404236316680908203125";
+  EXPECT_EQ(0x3FF0000000000000U, ParseBits(half));
+  EXPECT_EQ(0x3FF0000000000001U, ParseBits(half + "1"));
+  EXPECT_EQ(0x3FF0000000000000U, ParseBits(half.substr(0, half.size() - 1) +
+                                           "49999999999999999999999"));
+  // the deciding digit lies past the 768 digits kept for the comparison
+  EXPECT_EQ(0x3FF0000000000001U,
+            ParseBits(half + std::string(800, '0') + "1"));
+
+  // subnormals and the normal boundary
+  EXPECT_EQ(0x0000000000000001U, ParseBits("4.9406564584124654e-324"));
+  EXPECT_EQ(0x0000000000000000U, ParseBits("2.4703282292062327e-324"));
+  EXPECT_EQ(0x0000000000000001U, ParseBits("2.4703282292062328e-324"));
+  EXPECT_EQ(0x000FFFFFFFFFFFFFU, ParseBits("2.2250738585072009e-308"));
+  EXPECT_EQ(0x000FFFFFFFFFFFFFU, ParseBits("2.2250738585072011e-308"));
+  EXPECT_EQ(0x0010000000000000U, ParseBits("2.2250738585072012e-308"));
+  EXPECT_EQ(0x0010000000000000U, ParseBits("2.2250738585072014e-308"));
+
+  // largest double, and the last input that still rounds down to it
+  EXPECT_EQ(0x7FEFFFFFFFFFFFFFU, ParseBits("1.7976931348623157e308"));
+  EXPECT_EQ(0x7FEFFFFFFFFFFFFFU, ParseBits("1.7976931348623158e308"));
+  neujson::Document overflow;
+  EXPECT_EQ(neujson::error::NUMBER_TOO_BIG,
+            overflow.Parse("1.7976931348623159e308"));
+
+  // many digits in the integer part, leading zeros in the fraction
+  EXPECT_EQ(0x4415AF1D78B58C40U, ParseBits("100000000000000000000.0"));
+  EXPECT_EQ(0x3E7AD7F29ABCAF48U,
+            ParseBits("0.0000001000000000000000000000000000000000000001"));
+  EXPECT_EQ(0x0000000000000000U, ParseBits("0.0e999999999999"));
+  EXPECT_EQ(0x0000000000000000U, ParseBits("1e-999999999999"));
+}
+
 #if defined(_MSC_VER) || defined(__clang__)
 NEUJSON_DIAG_POP
 #endif
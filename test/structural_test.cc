@@ -0,0 +1,260 @@
+#include <cstdint>
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "neujson/document.h"
+#include "neujson/exception.h"
+#include "neujson/insitu_string_stream.h"
+#include "neujson/internal/structural_index.h"
+#include "neujson/padded_read_stream.h"
+#include "neujson/reader.h"
+#include "neujson/string_read_stream.h"
+#include "neujson/string_write_stream.h"
+#include "neujson/structural_reader.h"
+#include "neujson/writer.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+// byte by byte version of the structural index, escapes are resolved outside
+// of strings too, as the bit-parallel one does
+std::vector<uint32_t> ExpectIndex(const std::string_view json) {
+  const auto is_op = [](const char ch) {
+    return ch == '{' || ch == '}' || ch == '[' || ch == ']' || ch == ':' ||
+           ch == ',';
+  };
+  const auto is_ws = [](const char ch) {
+    return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+  };
+  std::vector<uint32_t> index;
+  bool escaped = false;
+  bool in_string = false;
+  bool follows_scalar = false;
+  for (std::size_t i = 0; i < json.size(); ++i) {
+    const char ch = json[i];
+    const bool quote = ch == '"' && !escaped;
+    escaped = ch == '\\' && !escaped;
+    const bool scalar = !is_op(ch) && !is_ws(ch);
+    if (in_string) {
+      in_string = !quote;
+    } else {
+      if (is_op(ch) || (scalar && !follows_scalar)) {
+        index.push_back(static_cast<uint32_t>(i));
+      }
+      in_string = quote;
+    }
+    follows_scalar = scalar && !quote;
+  }
+  return index;
+}
+
+std::vector<uint32_t> Index(const std::string_view json) {
+  std::vector<uint32_t> index(json.size());
+  neujson::internal::StructuralIndexer indexer;
+  index.resize(
+      indexer.Index(json.data(), json.data() + json.size(), index.data()));
+  return index;
+}
+
+struct Result {
+  neujson::error::ParseError err;
+  std::size_t offset;
+  std::string events;
+};
+
+template <unsigned Flags = neujson::ParseFlags::kDefault>
+Result ParseOnePass(const std::string_view json) {
+  neujson::StringReadStream read_stream(json);
+  neujson::StringWriteStream os;
+  neujson::Writer writer(os);
+  const auto result = neujson::Reader::Parse<Flags>(read_stream, writer);
+  return {result.err(), result.offset(), std::string(os.get())};
+}
+
+template <unsigned Flags = neujson::ParseFlags::kDefault>
+Result ParseTwoStage(neujson::StructuralReader &reader,
+                     const std::string_view json) {
+  neujson::StringReadStream read_stream(json);
+  neujson::StringWriteStream os;
+  neujson::Writer writer(os);
+  const auto result = reader.Parse<Flags>(read_stream, writer);
+  return {result.err(), result.offset(), std::string(os.get())};
+}
+
+// the same error at the same offset and the same events up to it
+#define EXPECT_SAME_PARSE(_reader, _json)                                      \
+  do {                                                                         \
+    const auto expect_ = ParseOnePass(_json);                                  \
+    const auto result_ = ParseTwoStage((_reader), (_json));                    \
+    EXPECT_EQ(expect_.err, result_.err) << (_json);                            \
+    EXPECT_EQ(expect_.offset, result_.offset) << (_json);                      \
+    EXPECT_EQ(expect_.events, result_.events) << (_json);                      \
+  } while (0)
+
+} // namespace
+
+TEST(structural, index) {
+  EXPECT_EQ(std::vector<uint32_t>(), Index(""));
+  EXPECT_EQ(std::vector<uint32_t>(), Index(" \n\t\r "));
+  EXPECT_EQ((std::vector<uint32_t>{0, 1, 4, 5, 6, 7, 8, 12, 13}),
+            Index(R"({"a":[1,2.5 ]})"));
+  EXPECT_EQ((std::vector<uint32_t>{0, 2, 6, 8}), Index(R"([ true, null)"));
+  // structural characters, escaped quotes and backslashes inside strings
+  EXPECT_EQ((std::vector<uint32_t>{0, 1, 11, 12, 20}),
+            Index(R"(["a,\"}[\\",":\\\"{"])"));
+
+  // random mixes across the block boundaries
+  std::mt19937 rng(20240609);
+  static constexpr char kAlphabet[] = {'"', '\\', '{', '}', '[', ']', ':',
+                                       ',', ' ', '\n', 'a', '1', '-'};
+  std::uniform_int_distribution<std::size_t> pick(0, sizeof(kAlphabet) - 1);
+  for (std::size_t length = 0; length < 300; ++length) {
+    std::string json(length, ' ');
+    for (auto &ch : json) {
+      ch = kAlphabet[pick(rng)];
+    }
+    EXPECT_EQ(ExpectIndex(json), Index(json)) << json;
+  }
+}
+
+TEST(structural, parse) {
+  neujson::StructuralReader reader;
+  const std::string_view kJson[] = {
+      "null",
+      " true ",
+      "-1.5e3",
+      R"("a\"b\\")",
+      "[]",
+      "{}",
+      " [ 1 , [ ] , { } , \"x\" ] ",
+      R"({"a" : [1, 2, {"b": null, "c": [true, false]}], "d": "€"})",
+      R"([1.7976931348623157e308, -0, 123456789012345678, NaN, -Infinity])",
+      // errors, with the byte at fault at each kind of position
+      "",
+      "  ",
+      "nul",
+      "[1,]",
+      "[1 2]",
+      "[1\"a\"]",
+      "[true\"a\"]",
+      "1\"a\"",
+      "12a",
+      "[12a]",
+      "{\"a\":1\"b\":2}",
+      "{\"a\"x:1}",
+      "{\"a\"}",
+      "{\"a\":}",
+      "{1:2}",
+      "{\"a\":1,}",
+      "[\"a\\x\"]",
+      "[\"abc",
+      "[\"a\\\"]",
+      "[1]x",
+      "[[1]x]",
+      "[[1]\"x\"]",
+      "null x",
+      "[1",
+      "[1,",
+      "{\"a\":1",
+      "{\"a\":1 \"b\"",
+      "[\x01]",
+      "[\"\x01\"]",
+      "1e309",
+  };
+  for (const auto json : kJson) {
+    EXPECT_SAME_PARSE(reader, json);
+  }
+
+  // the index outgrows the first parse and is reused afterwards
+  std::string big = "[";
+  for (int i = 0; i < 1000; ++i) {
+    big += R"({"key \"" : [1, "v\\"], "n" : -0.5},)";
+  }
+  big += "0]";
+  EXPECT_SAME_PARSE(reader, big);
+  EXPECT_SAME_PARSE(reader, "[1, 2]");
+}
+
+TEST(structural, random_errors) {
+  const std::string json =
+      R"({"a" : [1, -2.5e-3, "x\ty\"", true, null, {}], "b\\" : {"c": []},)"
+      R"( "d": ["€", false, 0, 12345678901234567890] })";
+  neujson::StructuralReader reader;
+  std::mt19937 rng(20240610);
+  std::uniform_int_distribution<std::size_t> position(0, json.size() - 1);
+  static constexpr char kAlphabet[] = {'"', '\\', '{', '}', '[', ']', ':',
+                                       ',', ' ', 'a', '1', 'e', 'n', '\0'};
+  std::uniform_int_distribution<std::size_t> pick(0, sizeof(kAlphabet) - 1);
+  for (int round = 0; round < 3000; ++round) {
+    std::string mutated = json;
+    for (int i = 0; i <= round % 3; ++i) {
+      mutated[position(rng)] = kAlphabet[pick(rng)];
+    }
+    EXPECT_SAME_PARSE(reader, mutated);
+  }
+}
+
+TEST(structural, streams) {
+  constexpr std::string_view json =
+      R"({"abc" : ["x\ty", "𝄞!", "plain", ""], "d":-1.5})";
+  neujson::Document expect;
+  EXPECT_EQ(neujson::error::OK, expect.Parse(json));
+  neujson::StringWriteStream expect_os;
+  neujson::Writer expect_writer(expect_os);
+  expect.WriteTo(expect_writer);
+
+  // documents are handlers like any other
+  neujson::StructuralReader reader;
+  neujson::PaddedReadStream padded_stream(json);
+  neujson::Document padded;
+  EXPECT_EQ(neujson::error::OK, reader.Parse(padded_stream, padded));
+  EXPECT_FALSE(padded_stream.hasNext());
+  neujson::StringWriteStream padded_os;
+  neujson::Writer padded_writer(padded_os);
+  padded.WriteTo(padded_writer);
+  EXPECT_EQ(expect_os.get(), padded_os.get());
+
+  std::string buffer(json);
+  neujson::InsituStringStream insitu_stream(buffer.data(), buffer.size());
+  neujson::StringWriteStream insitu_os;
+  neujson::Writer insitu_writer(insitu_os);
+  EXPECT_EQ(neujson::error::OK, reader.Parse(insitu_stream, insitu_writer));
+  EXPECT_EQ(expect_os.get(), insitu_os.get());
+}
+
+TEST(structural, flags) {
+  neujson::StructuralReader reader;
+  constexpr auto kStop = neujson::ParseFlags::kStopWhenDone;
+  for (const std::string_view json : {"[1] [2]", "12a", "{} x", "\"a\" 1"}) {
+    neujson::StringReadStream expect_stream(json);
+    neujson::StringWriteStream expect_os;
+    neujson::Writer expect_writer(expect_os);
+    EXPECT_EQ(neujson::error::OK,
+              neujson::Reader::Parse<kStop>(expect_stream, expect_writer));
+
+    neujson::StringReadStream read_stream(json);
+    neujson::StringWriteStream os;
+    neujson::Writer writer(os);
+    EXPECT_EQ(neujson::error::OK, reader.Parse<kStop>(read_stream, writer));
+    EXPECT_EQ(expect_os.get(), os.get());
+    EXPECT_EQ(expect_stream.getAddr(), read_stream.getAddr());
+  }
+
+  EXPECT_EQ(neujson::error::BAD_VALUE,
+            ParseTwoStage<neujson::ParseFlags::kNone>(reader, "[NaN]").err);
+  constexpr auto kUtf8 = neujson::ParseFlags::kValidateUtf8;
+  const std::string long_run(100, 'x');
+  for (const std::string &json :
+       {std::string("[\"\xC0\"]"), std::string("[\"\xC3\x28\"]"),
+        std::string("{\"a\xE2\x82\\n\":1}"),
+        "[\"" + long_run + "\xF0\x9D\x84\"]"}) {
+    const auto expect = ParseOnePass<kUtf8>(json);
+    const auto result = ParseTwoStage<kUtf8>(reader, json);
+    EXPECT_EQ(neujson::error::BAD_STRING_UTF8, result.err) << json;
+    EXPECT_EQ(expect.offset, result.offset) << json;
+  }
+}
@@ -0,0 +1,89 @@
+#include <cstdint>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "neujson/document.h"
+#include "neujson/string_write_stream.h"
+#include "neujson/tape_document.h"
+#include "neujson/writer.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+template <typename T> std::string Write(const T &value) {
+  neujson::StringWriteStream os;
+  neujson::Writer writer(os);
+  value.WriteTo(writer);
+  return std::string(os.get());
+}
+
+} // namespace
+
+TEST(tape, scalars) {
+  neujson::TapeDocument doc;
+  EXPECT_TRUE(doc.GetRoot().IsNull());
+
+  EXPECT_EQ(neujson::error::OK,
+            doc.Parse(R"([null,true,false,-7,-9007199254740993,-0.5,"s"])"));
+  const auto root = doc.GetRoot();
+  EXPECT_EQ(7UL, root.GetSize());
+  EXPECT_TRUE(root[0].IsNull());
+  EXPECT_TRUE(root[1].GetBool());
+  EXPECT_FALSE(root[2].GetBool());
+  EXPECT_EQ(-7, root[3].GetInt32());
+  EXPECT_EQ(-7, root[3].GetInt64());
+  EXPECT_EQ(INT64_C(-9007199254740993), root[4].GetInt64());
+  EXPECT_EQ(-0.5, root[5].GetDouble());
+  EXPECT_EQ("s", root[6].GetStringView());
+  EXPECT_THROW((void)root[7], std::out_of_range);
+
+  EXPECT_EQ(neujson::error::OK, doc.Parse("\"root\""));
+  EXPECT_EQ("root", doc.GetRoot().GetStringView());
+  EXPECT_EQ(1UL, doc.TapeSize());
+}
+
+TEST(tape, containers) {
+  constexpr std::string_view kJson =
+      R"({"a":[1,-2.5,"long enough to be a heap string",true,null],)"
+      R"("b":{"c":{},"d":[]},"e":"","f":[[1,2,3,4,5,6,7,8,9,10]]})";
+  neujson::TapeDocument doc;
+  EXPECT_EQ(neujson::error::OK, doc.Parse(kJson));
+  EXPECT_EQ(kJson, Write(doc));
+
+  const auto root = doc.GetRoot();
+  EXPECT_EQ(4UL, root.GetSize());
+  EXPECT_EQ(-2.5, root["a"][1].GetDouble());
+  EXPECT_EQ("long enough to be a heap string", root["a"][2].GetStringView());
+  EXPECT_TRUE(root["b"]["c"].GetObject().empty());
+  EXPECT_EQ(0UL, root["b"]["d"].GetSize());
+  EXPECT_EQ(10, root["f"][0][9].GetInt32());
+  EXPECT_EQ(root.MemberEnd(), root.FindMember("g"));
+
+  // members in document order, skipping over nested containers in one step
+  std::string keys;
+  for (const auto &member : root.GetObject()) {
+    keys += member.key_.GetStringView();
+  }
+  EXPECT_EQ("abef", keys);
+  int32_t sum = 0;
+  for (const auto value : root["f"][0].GetArray()) {
+    sum += value.GetInt32();
+  }
+  EXPECT_EQ(55, sum);
+
+  // the same reading as the tree
+  neujson::Document tree;
+  EXPECT_EQ(neujson::error::OK, tree.Parse(kJson));
+  EXPECT_EQ(Write(tree), Write(doc));
+}
+
+TEST(tape, error) {
+  neujson::TapeDocument doc;
+  EXPECT_EQ(neujson::error::OK, doc.Parse("[1,2,3]"));
+  const auto result = doc.Parse("[1,2,");
+  EXPECT_NE(neujson::error::OK, result);
+  EXPECT_TRUE(doc.GetRoot().IsNull());
+}
@@ -0,0 +1,343 @@
+#include <cstdint>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "neujson/document.h"
+#include "neujson/string_write_stream.h"
+#include "neujson/value.h"
+#include "neujson/writer.h"
+
+#include "gtest/gtest.h"
+
+TEST(value, layout) {
+  EXPECT_EQ(16UL, sizeof(neujson::Value));
+  EXPECT_EQ(32UL, sizeof(neujson::Member));
+}
+
+TEST(value, scalars) {
+  neujson::Value value;
+  EXPECT_TRUE(value.IsNull());
+  value.SetBool(true);
+  EXPECT_TRUE(value.GetBool());
+  value.SetInt32(-7);
+  EXPECT_EQ(-7, value.GetInt32());
+  EXPECT_EQ(-7, value.GetInt64());
+  value.SetInt64(INT64_MIN);
+  EXPECT_EQ(INT64_MIN, value.GetInt64());
+  value.SetDouble(-0.5);
+  EXPECT_EQ(-0.5, value.GetDouble());
+  EXPECT_EQ(1UL, value.GetSize());
+}
+
+TEST(value, string) {
+  neujson::Value empty(neujson::NEU_STRING);
+  EXPECT_EQ("", empty.GetStringView());
+
+  const std::string long_string(100, 'x');
+  neujson::Value value(long_string);
+  EXPECT_EQ(long_string, value.GetStringView());
+  EXPECT_NE(long_string.data(), value.GetStringView().data());
+
+  // copies share the characters, which outlive the original
+  auto *copy = new neujson::Value(value);
+  EXPECT_EQ(value.GetStringView().data(), copy->GetStringView().data());
+  value.SetNull();
+  EXPECT_EQ(long_string, copy->GetStringView());
+
+  // a string set from itself
+  copy->SetString(copy->GetStringView().substr(1));
+  EXPECT_EQ(long_string.substr(1), copy->GetStringView());
+  delete copy;
+
+  // borrowed characters are not copied
+  const neujson::Value ref{neujson::StringRef(long_string)};
+  EXPECT_EQ(long_string.data(), ref.GetStringView().data());
+  neujson::Value ref_copy(ref);
+  EXPECT_EQ(long_string.data(), ref_copy.GetStringView().data());
+}
+
+TEST(value, short_string) {
+  // up to 14 characters live in the value itself
+  const std::string fits(14, 'y');
+  neujson::Value value(fits);
+  EXPECT_EQ(fits, value.GetStringView());
+  EXPECT_EQ(0UL, value.UseCount());
+  const auto *begin = reinterpret_cast<const char *>(&value);
+  EXPECT_EQ(begin, value.GetStringView().data());
+
+  const std::string too_long(15, 'y');
+  const neujson::Value heap(too_long);
+  EXPECT_EQ(too_long, heap.GetStringView());
+  EXPECT_EQ(1UL, heap.UseCount());
+
+  // copies take their own characters
+  neujson::Value copy(value);
+  EXPECT_NE(value.GetStringView().data(), copy.GetStringView().data());
+  value.SetNull();
+  EXPECT_EQ(fits, copy.GetStringView());
+
+  // a string set from itself, and assigned across the two kinds
+  copy.SetString(copy.GetStringView().substr(2));
+  EXPECT_EQ(fits.substr(2), copy.GetStringView());
+  copy = heap;
+  EXPECT_EQ(too_long, copy.GetStringView());
+  copy = neujson::Value("");
+  EXPECT_EQ("", copy.GetStringView());
+
+  neujson::Document doc;
+  EXPECT_EQ(neujson::error::OK,
+            doc.Parse(R"({"key":"short","":"a string of the heap kind"})"));
+  EXPECT_EQ("short", doc["key"].GetStringView());
+  EXPECT_EQ("a string of the heap kind", doc[""].GetStringView());
+}
+
+TEST(value, move) {
+  neujson::Value value("abc");
+  neujson::Value moved(std::move(value));
+  EXPECT_TRUE(value.IsNull());
+  EXPECT_EQ("abc", moved.GetStringView());
+
+  neujson::Value assigned;
+  assigned = std::move(moved);
+  EXPECT_TRUE(moved.IsNull());
+  EXPECT_EQ("abc", assigned.GetStringView());
+}
+
+TEST(value, array) {
+  neujson::Value array(neujson::NEU_ARRAY);
+  EXPECT_EQ(0UL, array.GetSize());
+  EXPECT_TRUE(array.GetArray()->empty());
+  EXPECT_THROW((void)array[0], std::out_of_range);
+
+  for (int32_t i = 0; i < 100; ++i) {
+    array.AddValue(neujson::Value(i));
+  }
+  // an element added from the array itself survives the growth
+  array.AddValue(array[0]);
+  EXPECT_EQ(101UL, array.GetSize());
+  for (int32_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(i, array[static_cast<std::size_t>(i)].GetInt32());
+  }
+  EXPECT_EQ(0, array.GetArray()->back().GetInt32());
+  EXPECT_THROW((void)array[101], std::out_of_range);
+
+  // copies share the elements, also those added afterwards
+  neujson::Value copy(array);
+  array.AddValue(neujson::Value("x"));
+  EXPECT_EQ(102UL, copy.GetSize());
+  EXPECT_EQ("x", copy[101].GetStringView());
+  array.SetNull();
+  EXPECT_EQ(102UL, copy.GetSize());
+}
+
+TEST(value, object) {
+  neujson::Value object(neujson::NEU_OBJECT);
+  EXPECT_EQ(object.MemberBegin(), object.MemberEnd());
+  EXPECT_EQ(object.MemberEnd(), object.FindMember("a"));
+
+  for (int32_t i = 0; i < 50; ++i) {
+    object.AddMember(std::to_string(i).c_str(), i);
+  }
+  object.AddMember("nested", neujson::Value(neujson::NEU_ARRAY))
+      .AddValue(neujson::Value(true));
+  EXPECT_EQ(51UL, object.GetSize());
+  EXPECT_EQ(42, object["42"].GetInt32());
+  EXPECT_TRUE(object["nested"][0].GetBool());
+  EXPECT_EQ("0", object.MemberBegin()->key_.GetStringView());
+
+  int32_t i = 0;
+  for (auto it = object.MemberBegin(); i < 50; ++it, ++i) {
+    EXPECT_EQ(std::to_string(i), it->key_.GetStringView());
+    EXPECT_EQ(i, it->value_.GetInt32());
+  }
+}
+
+TEST(value, object_index) {
+  // past the threshold lookups go through the hash index, which follows
+  // every added member
+  neujson::Value object(neujson::NEU_OBJECT);
+  for (int32_t i = 0; i < 1000; ++i) {
+    object.AddMember(("key " + std::to_string(i)).c_str(), i);
+    for (int32_t j = 0; j <= i; j += 97) {
+      EXPECT_EQ(j, object["key " + std::to_string(j)].GetInt32());
+    }
+    const std::string next = "key " + std::to_string(i + 1);
+    EXPECT_EQ(object.MemberEnd(), object.FindMember(next));
+  }
+  EXPECT_EQ(object.MemberEnd(), object.FindMember(""));
+  EXPECT_EQ(object.MemberEnd(), object.FindMember("key"));
+
+  // the members keep their order
+  int32_t i = 0;
+  for (auto it = object.MemberBegin(); it != object.MemberEnd(); ++it, ++i) {
+    EXPECT_EQ("key " + std::to_string(i), it->key_.GetStringView());
+  }
+
+  // copies share the index as they share the members
+  neujson::Value copy(object);
+  object.AddMember("added", true);
+  EXPECT_TRUE(copy["added"].GetBool());
+
+  // the index is built by the first lookup, however many members came first
+  neujson::Value unsearched(neujson::NEU_OBJECT);
+  for (int32_t j = 0; j < 1000; ++j) {
+    unsearched.AddMember(("key " + std::to_string(j)).c_str(), j);
+  }
+  EXPECT_EQ(999, unsearched["key 999"].GetInt32());
+  unsearched.AddMember("added", true);
+  EXPECT_TRUE(unsearched["added"].GetBool());
+  EXPECT_EQ(0, unsearched["key 0"].GetInt32());
+
+  // parsed objects, in an arena or not, are looked up from several threads
+  std::string json = "{";
+  for (int32_t j = 0; j < 100; ++j) {
+    json += (j == 0 ? "\"" : ",\"") + std::to_string(j) + "\":" +
+            std::to_string(j);
+  }
+  json += "}";
+  neujson::Document arena_doc(nullptr, 0);
+  EXPECT_EQ(neujson::error::OK, arena_doc.Parse(json));
+  neujson::Document heap_doc;
+  EXPECT_EQ(neujson::error::OK, heap_doc.Parse(json));
+  for (const neujson::Document *doc : {&arena_doc, &heap_doc}) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([doc] {
+        for (int32_t j = 0; j < 100; ++j) {
+          EXPECT_EQ(j, (*doc)[std::to_string(j)].GetInt32());
+        }
+        EXPECT_EQ(doc->MemberEnd(), doc->FindMember("100"));
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+}
+
+TEST(value, document) {
+  constexpr std::string_view kJson =
+      R"({"a":[1,-2.5,"long enough to be a heap string",true,null],)"
+      R"("b":{"c":{},"d":[]},"e":"")"
+      "}";
+  neujson::Document doc;
+  EXPECT_EQ(neujson::error::OK, doc.Parse(kJson));
+  neujson::StringWriteStream os;
+  neujson::Writer writer(os);
+  doc.WriteTo(writer);
+  EXPECT_EQ(kJson, os.get());
+
+  // containers are allocated once they are complete, with their exact size
+  EXPECT_EQ(3UL, doc.GetObject()->capacity());
+  EXPECT_EQ(5UL, doc["a"].GetArray()->capacity());
+  EXPECT_EQ(2UL, doc["b"].GetObject()->capacity());
+  EXPECT_TRUE(doc["b"]["d"].GetArray()->empty());
+
+  // a value taken out of the document outlives it
+  auto *document = new neujson::Document();
+  EXPECT_EQ(neujson::error::OK, document->Parse(kJson));
+  const neujson::Value a = (*document)["a"];
+  delete document;
+  EXPECT_EQ(5UL, a.GetSize());
+  EXPECT_EQ("long enough to be a heap string", a[2].GetStringView());
+}
+
+TEST(value, intern_keys) {
+  constexpr std::string_view kJson =
+      R"([{"audienceSubCategoryId":1,"id":2},)"
+      R"({"audienceSubCategoryId":3,"id":4}])";
+  constexpr unsigned kFlags =
+      neujson::ParseFlags::kDefault | neujson::ParseFlags::kInternKeys;
+
+  // keys too long to be inline share one string
+  neujson::Document doc;
+  EXPECT_EQ(neujson::error::OK, doc.Parse<kFlags>(kJson));
+  const auto &first = doc[0].MemberBegin()->key_;
+  const auto &second = doc[1].MemberBegin()->key_;
+  EXPECT_EQ(first.GetStringView().data(), second.GetStringView().data());
+  EXPECT_EQ(2UL, first.UseCount());
+  EXPECT_EQ(3, doc[1][first.GetStringView()].GetInt32());
+  EXPECT_EQ(4, doc[1]["id"].GetInt32());
+
+  // the table is the parse's own, the tree owns the keys
+  EXPECT_EQ(neujson::error::OK, doc.Parse<kFlags>(kJson));
+  EXPECT_EQ(2UL, doc[0].MemberBegin()->key_.UseCount());
+
+  neujson::Document arena(nullptr, 0);
+  EXPECT_EQ(neujson::error::OK, arena.Parse<kFlags>(kJson));
+  EXPECT_EQ(arena[0].MemberBegin()->key_.GetStringView().data(),
+            arena[1].MemberBegin()->key_.GetStringView().data());
+
+  // not asked for
+  neujson::Document plain;
+  EXPECT_EQ(neujson::error::OK, plain.Parse(kJson));
+  EXPECT_NE(plain[0].MemberBegin()->key_.GetStringView().data(),
+            plain[1].MemberBegin()->key_.GetStringView().data());
+}
+
+namespace {
+
+// every counted string and container of the tree has a single owner
+void ExpectSingleOwners(const neujson::Value &value) {
+  switch (value.GetType()) {
+  case neujson::NEU_STRING:
+    EXPECT_GE(1UL, value.UseCount());
+    break;
+  case neujson::NEU_ARRAY:
+    EXPECT_GE(1UL, value.UseCount());
+    for (const auto &element : *value.GetArray()) {
+      ExpectSingleOwners(element);
+    }
+    break;
+  case neujson::NEU_OBJECT:
+    EXPECT_GE(1UL, value.UseCount());
+    for (const auto &member : *value.GetObject()) {
+      ExpectSingleOwners(member.key_);
+      ExpectSingleOwners(member.value_);
+    }
+    break;
+  default:
+    EXPECT_EQ(0UL, value.UseCount());
+  }
+}
+
+} // namespace
+
+TEST(value, use_count) {
+  // building a document moves every value into place
+  constexpr std::string_view kJson =
+      R"({"a":[1,"a string long enough for the heap",[true]],"b":{"c":"d"}})";
+  neujson::Document doc;
+  EXPECT_EQ(neujson::error::OK, doc.Parse(kJson));
+  ExpectSingleOwners(doc);
+
+  // and reading it touches no count
+  const neujson::Value &a = doc["a"];
+  EXPECT_EQ(3UL, a.GetSize());
+  EXPECT_EQ("a string long enough for the heap", a[1].GetStringView());
+  EXPECT_TRUE(a[2][0].GetBool());
+  EXPECT_NE(doc.MemberEnd(), doc.FindMember("b"));
+  EXPECT_EQ("d", doc["b"]["c"].GetStringView());
+  neujson::StringWriteStream os;
+  neujson::Writer writer(os);
+  doc.WriteTo(writer);
+  ExpectSingleOwners(doc);
+
+  // neither does building by hand from temporaries
+  neujson::Value object(neujson::NEU_OBJECT);
+  object.AddMember("key", neujson::Value("a string long enough for the heap"))
+      .SetArray()
+      .AddValue(neujson::Value("another string long enough for the heap"));
+  ExpectSingleOwners(object);
+
+  // copies share and count
+  const neujson::Value copy = a;
+  EXPECT_EQ(2UL, a.UseCount());
+  EXPECT_EQ(2UL, copy.UseCount());
+  EXPECT_EQ(1UL, a[1].UseCount());
+}